@@ -0,0 +1,167 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cassert>
+
+const GLuint BVH_LEAF_TRIANGLES = 4;
+
+BVH::BVH(const vector<glm::vec4>& trianglePositions)
+	: source(trianglePositions)
+{
+	GLuint triangleCount = trianglePositions.size() / 3;
+	for (GLuint i = 0; i < triangleCount; i++)
+	{
+		order.push_back(i);
+		centroids.push_back(glm::vec3(trianglePositions[i * 3] + trianglePositions[i * 3 + 1] + trianglePositions[i * 3 + 2]) / 3.0f);
+	}
+
+	BVHNode root;
+	root.leftFirst = 0;
+	root.count = triangleCount;
+	nodes.reserve(triangleCount * 2);
+	nodes.push_back(root);
+	maxDepth = 0;
+	UpdateBounds(0);
+	Subdivide(0, 0);
+	// a traversal holds at most one pending sibling per level
+	assert(maxDepth + 1 <= BVH_STACK_SIZE);
+
+	for (GLuint i = 0; i < triangleCount; i++)
+	{
+		triangles.push_back(trianglePositions[order[i] * 3]);
+		triangles.push_back(trianglePositions[order[i] * 3 + 1]);
+		triangles.push_back(trianglePositions[order[i] * 3 + 2]);
+	}
+	order.clear();
+	centroids.clear();
+}
+
+void BVH::UpdateBounds(GLuint nodeIndex)
+{
+	BVHNode& node = nodes[nodeIndex];
+	node.minBound = glm::vec3(1e30f);
+	node.maxBound = glm::vec3(-1e30f);
+	for (GLuint i = node.leftFirst; i < node.leftFirst + node.count; i++)
+	{
+		for (GLuint v = 0; v < 3; v++)
+		{
+			glm::vec3 position(source[order[i] * 3 + v]);
+			node.minBound = glm::min(node.minBound, position);
+			node.maxBound = glm::max(node.maxBound, position);
+		}
+	}
+}
+
+void BVH::Subdivide(GLuint nodeIndex, GLuint depth)
+{
+	GLuint first = nodes[nodeIndex].leftFirst;
+	GLuint count = nodes[nodeIndex].count;
+	maxDepth = glm::max(maxDepth, depth);
+	// degenerate clusters stay one larger leaf rather than outgrow the stack
+	if (count <= BVH_LEAF_TRIANGLES || depth == BVH_MAX_DEPTH)
+		return;
+
+	// split the centroid bounds in the middle of their longest axis
+	glm::vec3 minCentroid(1e30f), maxCentroid(-1e30f);
+	for (GLuint i = first; i < first + count; i++)
+	{
+		minCentroid = glm::min(minCentroid, centroids[order[i]]);
+		maxCentroid = glm::max(maxCentroid, centroids[order[i]]);
+	}
+	glm::vec3 extent = maxCentroid - minCentroid;
+	int axis = 0;
+	if (extent.y > extent[axis])
+		axis = 1;
+	if (extent.z > extent[axis])
+		axis = 2;
+	float split = minCentroid[axis] + extent[axis] * 0.5f;
+
+	GLuint* begin = &order[0] + first;
+	GLuint* end = begin + count;
+	GLuint* middle = std::partition(begin, end, [&](GLuint triangle) { return centroids[triangle][axis] < split; });
+	if (middle == begin || middle == end)
+	{
+		// all centroids on one side, fall back to a median split
+		middle = begin + count / 2;
+		std::nth_element(begin, middle, end, [&](GLuint a, GLuint b) { return centroids[a][axis] < centroids[b][axis]; });
+	}
+	GLuint leftCount = middle - begin;
+
+	GLuint leftIndex = nodes.size();
+	BVHNode left, right;
+	left.leftFirst = first;
+	left.count = leftCount;
+	right.leftFirst = first + leftCount;
+	right.count = count - leftCount;
+	nodes.push_back(left);
+	nodes.push_back(right);
+
+	nodes[nodeIndex].leftFirst = leftIndex;
+	nodes[nodeIndex].count = 0;
+
+	UpdateBounds(leftIndex);
+	UpdateBounds(leftIndex + 1);
+	Subdivide(leftIndex, depth + 1);
+	Subdivide(leftIndex + 1, depth + 1);
+}
+
+static bool HitBox(glm::vec3 origin, glm::vec3 invDir, float tMax, const BVHNode& node)
+{
+	glm::vec3 t0 = (node.minBound - origin) * invDir;
+	glm::vec3 t1 = (node.maxBound - origin) * invDir;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, tMax));
+	return enter <= exit;
+}
+
+static bool HitTriangle(glm::vec3 origin, glm::vec3 dir, float tMax, glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+{
+	glm::vec3 edge1 = v1 - v0;
+	glm::vec3 edge2 = v2 - v0;
+	glm::vec3 p = glm::cross(dir, edge2);
+	float det = glm::dot(edge1, p);
+	if (glm::abs(det) < 1e-8f)
+		return false;
+	float invDet = 1.0f / det;
+	glm::vec3 s = origin - v0;
+	float u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+	glm::vec3 q = glm::cross(s, edge1);
+	float v = glm::dot(dir, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+	float t = glm::dot(edge2, q) * invDet;
+	return t > 0.0f && t < tMax;
+}
+
+// same traversal as Occluded() in raytraced_shadows.comp
+bool BVH::Occluded(glm::vec3 origin, glm::vec3 dir, float tMax) const
+{
+	glm::vec3 invDir = 1.0f / dir;
+	GLuint stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = nodes[stack[--stackSize]];
+		if (!HitBox(origin, invDir, tMax, node))
+			continue;
+		if (node.count > 0)
+		{
+			for (GLuint i = node.leftFirst; i < node.leftFirst + node.count; i++)
+			{
+				if (HitTriangle(origin, dir, tMax, glm::vec3(triangles[i * 3]), glm::vec3(triangles[i * 3 + 1]), glm::vec3(triangles[i * 3 + 2])))
+					return true;
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= (int)BVH_STACK_SIZE);
+			stack[stackSize++] = node.leftFirst;
+			stack[stackSize++] = node.leftFirst + 1;
+		}
+	}
+	return false;
+}
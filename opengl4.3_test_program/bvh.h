@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+
+using namespace std;
+
+// matches the std430 layout of the BVHNode struct in the tracing shaders
+struct BVHNode
+{
+	glm::vec3 minBound;
+	GLuint leftFirst;
+	glm::vec3 maxBound;
+	GLuint count;
+};
+
+// nodes deeper than this are not split, so a traversal stack of
+// BVH_STACK_SIZE entries never overflows; STACK_SIZE in raytraced_shadows.comp
+const GLuint BVH_MAX_DEPTH = 31;
+const GLuint BVH_STACK_SIZE = BVH_MAX_DEPTH + 1;
+
+// Bounding volume hierarchy over world space triangles. Leaves hold count
+// triangles starting at leftFirst; inner nodes have count 0 and their two
+// children at leftFirst and leftFirst + 1.
+class BVH
+{
+public:
+	BVH(const vector<glm::vec4>& trianglePositions);
+	bool Occluded(glm::vec3 origin, glm::vec3 dir, float tMax) const;
+	vector<BVHNode> nodes;
+	vector<glm::vec4> triangles;
+	// depth of the deepest leaf, the root is at depth 0
+	GLuint maxDepth;
+private:
+	vector<GLuint> order;
+	vector<glm::vec3> centroids;
+	const vector<glm::vec4>& source;
+	void UpdateBounds(GLuint nodeIndex);
+	void Subdivide(GLuint nodeIndex, GLuint depth);
+};
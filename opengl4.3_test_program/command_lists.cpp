@@ -0,0 +1,112 @@
+#include "command_lists.h"
+
+bool SphereInFrustum(const glm::mat4& viewProjection, const glm::vec3& center, GLfloat radius)
+{
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		glm::vec4 planes[2] = { row3 + row, row3 - row };
+		for (int p = 0; p < 2; p++)
+		{
+			if (glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius * glm::length(glm::vec3(planes[p])))
+				return false;
+		}
+	}
+	return true;
+}
+
+CommandListBuilder::CommandListBuilder(unsigned int workerCount)
+{
+	this->workerCount = workerCount;
+	job = NULL;
+	context = NULL;
+	passes = NULL;
+	build = NULL;
+	jobs = 0;
+	pending = 0;
+	generation = 0;
+	stop = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(thread(&CommandListBuilder::Work, this));
+}
+
+CommandListBuilder::~CommandListBuilder()
+{
+	{
+		lock_guard<mutex> lock(jobMutex);
+		stop = true;
+	}
+	jobReady.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void CommandListBuilder::Build(const vector<PassDesc>& passes, BuildFunction build)
+{
+	lists.resize(passes.size());
+	this->passes = &passes;
+	this->build = build;
+	Run(passes.size(), BuildJob, this);
+}
+
+void CommandListBuilder::BuildJob(void* context, unsigned int job)
+{
+	CommandListBuilder* builder = (CommandListBuilder*)context;
+	RenderQueue& list = builder->lists[job];
+	list.Clear();
+	builder->build((*builder->passes)[job], list);
+	list.Sort();
+}
+
+void CommandListBuilder::Run(unsigned int jobCount, JobFunction job, void* context)
+{
+	if (jobCount == 0)
+		return;
+	{
+		lock_guard<mutex> lock(jobMutex);
+		this->job = job;
+		this->context = context;
+		pending = jobCount;
+		jobs = (uint64_t)jobCount << 32;
+		generation++;
+	}
+	jobReady.notify_all();
+	RunJobs();
+
+	unique_lock<mutex> lock(jobMutex);
+	jobDone.wait(lock, [this] { return pending == 0; });
+}
+
+void CommandListBuilder::Work()
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			unique_lock<mutex> lock(jobMutex);
+			jobReady.wait(lock, [this, seen] { return stop || generation != seen; });
+			if (stop)
+				return;
+			seen = generation;
+		}
+		RunJobs();
+	}
+}
+
+void CommandListBuilder::RunJobs()
+{
+	for (;;)
+	{
+		uint64_t claimed = jobs++;
+		unsigned int i = (unsigned int)claimed;
+		if (i >= (unsigned int)(claimed >> 32))
+			return;
+		job(context, i);
+		if (--pending == 0)
+		{
+			lock_guard<mutex> lock(jobMutex);
+			jobDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "render_queue.h"
+
+using namespace std;
+
+// everything a worker needs to build one pass, plain data only
+struct PassDesc
+{
+	glm::mat4 viewProjection;
+	glm::vec3 eye;
+	// off for passes whose frustum does not bound what they render
+	bool cull;
+	bool dynamicOnly;
+	// draws the position stream, see DepthGeometry
+	bool depthOnly;
+	Shader* shader;
+	Shader* reverseShader;
+	GLuint VAO;
+};
+
+// conservative sphere test against the planes of a view projection matrix
+bool SphereInFrustum(const glm::mat4& viewProjection, const glm::vec3& center, GLfloat radius);
+
+// Builds the command lists of a frame's passes, the camera views and the
+// shadow cube faces, on worker threads. Building only culls, fills and
+// sorts plain RenderQueue items and never touches GL, so the GL thread just
+// replays the finished lists with Submit. The calling thread builds too.
+class CommandListBuilder
+{
+public:
+	typedef void (*BuildFunction)(const PassDesc& pass, RenderQueue& list);
+	typedef void (*JobFunction)(void* context, unsigned int job);
+	CommandListBuilder(unsigned int workerCount);
+	~CommandListBuilder();
+	// returns once every pass has a sorted list in lists, in pass order
+	void Build(const vector<PassDesc>& passes, BuildFunction build);
+	// the same workers for other per frame work, returns once job(context, i)
+	// has run for every i below jobCount
+	void Run(unsigned int jobCount, JobFunction job, void* context);
+	vector<RenderQueue> lists;
+	unsigned int workerCount;
+private:
+	static void BuildJob(void* context, unsigned int job);
+	void Work();
+	void RunJobs();
+	vector<thread> workers;
+	mutex jobMutex;
+	condition_variable jobReady, jobDone;
+	JobFunction job;
+	void* context;
+	const vector<PassDesc>* passes;
+	BuildFunction build;
+	// job count in the high half and next job in the low half, so a late
+	// worker can never claim a job of the next run against a stale count
+	atomic<uint64_t> jobs;
+	atomic<unsigned int> pending;
+	unsigned int generation;
+	bool stop;
+};
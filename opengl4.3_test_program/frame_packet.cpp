@@ -0,0 +1,45 @@
+#include "frame_packet.h"
+
+FramePacketExchange::FramePacketExchange(const FramePacket& initial)
+{
+	pending = initial;
+	fresh = true;
+	stopped = false;
+}
+
+void FramePacketExchange::Publish(const FramePacket& packet)
+{
+	lock_guard<mutex> lock(packetMutex);
+	// a replaced packet must not drop its one shot requests
+	bool instancesDirty = fresh && pending.instancesDirty;
+	bool reportStats = fresh && pending.reportStats;
+	pending = packet;
+	pending.instancesDirty |= instancesDirty;
+	pending.reportStats |= reportStats;
+	fresh = true;
+}
+
+void FramePacketExchange::Stop()
+{
+	lock_guard<mutex> lock(packetMutex);
+	stopped = true;
+}
+
+bool FramePacketExchange::Acquire(FramePacket& packet)
+{
+	lock_guard<mutex> lock(packetMutex);
+	if (stopped)
+		return false;
+	if (fresh)
+	{
+		packet = pending;
+		fresh = false;
+	}
+	else
+	{
+		// the last packet again, its one shot requests are already done
+		packet.instancesDirty = false;
+		packet.reportStats = false;
+	}
+	return true;
+}
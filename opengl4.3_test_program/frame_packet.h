@@ -0,0 +1,46 @@
+#pragma once
+#include <mutex>
+#include "camera.h"
+
+using namespace std;
+
+// Everything the render thread needs from the main thread for one frame,
+// plain data copied across so neither thread touches the other's state.
+struct FramePacket
+{
+	Camera camera, overviewCamera;
+	bool useShadowBinning;
+	bool useRayTracedShadows;
+	bool useShadowVolumes;
+	bool useBakedShadows;
+	bool useMultiView;
+	bool useFaceCulling;
+	bool useInstanceStress;
+	bool useGpuDriven;
+	bool useStaticBatching;
+	bool useCommandLists;
+	// one shot requests, kept until the render thread has seen them
+	bool instancesDirty;
+	bool reportStats;
+};
+
+// Double buffered hand over of frame packets between the main thread and the
+// render thread. Neither side ever waits for the other, a newer packet simply
+// replaces one the render thread has not picked up yet.
+class FramePacketExchange
+{
+public:
+	// the render thread starts from the initial packet
+	FramePacketExchange(const FramePacket& initial);
+	// main thread
+	void Publish(const FramePacket& packet);
+	void Stop();
+	// render thread, takes the newest packet or keeps the last one when
+	// nothing new has arrived, returns false once the main thread has stopped
+	bool Acquire(FramePacket& packet);
+private:
+	FramePacket pending;
+	bool fresh;
+	bool stopped;
+	mutex packetMutex;
+};
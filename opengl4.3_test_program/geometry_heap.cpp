@@ -0,0 +1,113 @@
+#include "geometry_heap.h"
+#include "gl_state.h"
+#include <iostream>
+#include <vector>
+
+GeometryHeap::GeometryHeap(GLuint vertexCapacity, GLuint indexCapacity)
+{
+	this->vertexCapacity = vertexCapacity;
+	this->indexCapacity = indexCapacity;
+	vertexCount = 0;
+	indexCount = 0;
+	rangeCount = 0;
+	positionCount = 0;
+
+	glGenBuffers(1, &vertexBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, vertexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, vertexCapacity * sizeof(PackedVertex), NULL, GL_STATIC_DRAW);
+	glGenBuffers(1, &boundsBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, MAX_QUANTIZATION_BOUNDS * sizeof(QuantizationBounds), NULL, GL_STATIC_DRAW);
+	// welding never adds positions, so the vertex capacity bounds them too
+	glGenBuffers(1, &positionBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, positionBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, vertexCapacity * sizeof(PackedPosition), NULL, GL_STATIC_DRAW);
+	glGenBuffers(1, &lightmapBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, lightmapBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, vertexCapacity * sizeof(glm::vec2), NULL, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &indexBuffer);
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * sizeof(GeometryIndex), NULL, GL_STATIC_DRAW);
+	GLState::BindVertexArray(0);
+}
+
+GeometryRange GeometryHeap::Allocate(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, const glm::vec2* lightmapCoords)
+{
+	GeometryRange range = { 0, 0, 0, 0, 0, 0, 0 };
+	// the position stream's indices follow the range's own
+	if (this->vertexCount + vertexCount > vertexCapacity || this->indexCount + indexCount * 2 > indexCapacity)
+	{
+		std::cout << "ERROR::GEOMETRY_HEAP::OUT_OF_SPACE" << std::endl;
+		return range;
+	}
+	if (vertexCount > GEOMETRY_RANGE_MAX_VERTICES || rangeCount == MAX_QUANTIZATION_BOUNDS)
+	{
+		std::cout << "ERROR::GEOMETRY_HEAP::RANGE_TOO_LARGE" << std::endl;
+		return range;
+	}
+	range.firstVertex = this->vertexCount;
+	range.vertexCount = vertexCount;
+	range.firstIndex = this->indexCount;
+	range.indexCount = indexCount;
+	std::vector<glm::vec3> positions;
+	std::vector<GLuint> positionIndices;
+	BuildPositionStream(vertices, vertexCount, indices, indexCount, positions, positionIndices);
+	range.firstPosition = this->positionCount;
+	range.positionCount = positions.size();
+	range.firstPositionIndex = this->indexCount + indexCount;
+
+	QuantizationBounds bounds = ComputeQuantizationBounds(vertices, vertexCount);
+	std::vector<PackedVertex> packed(vertexCount);
+	PackVertices(vertices, vertexCount, bounds, rangeCount, packed.data());
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, vertexBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.firstVertex * sizeof(PackedVertex), vertexCount * sizeof(PackedVertex), packed.data());
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, rangeCount * sizeof(QuantizationBounds), sizeof(QuantizationBounds), &bounds);
+	std::vector<PackedPosition> packedPositions(positions.size());
+	PackPositions(positions.data(), positions.size(), bounds, rangeCount, packedPositions.data());
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, positionBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.firstPosition * sizeof(PackedPosition), positions.size() * sizeof(PackedPosition), packedPositions.data());
+	std::vector<glm::vec2> noLightmap;
+	if (!lightmapCoords)
+	{
+		noLightmap.assign(vertexCount, glm::vec2(-1.0f));
+		lightmapCoords = noLightmap.data();
+	}
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, lightmapBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.firstVertex * sizeof(glm::vec2), vertexCount * sizeof(glm::vec2), lightmapCoords);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	// indices stay relative to the mesh, draws pass firstVertex as base vertex
+	std::vector<GeometryIndex> narrowed(indices, indices + indexCount);
+	narrowed.insert(narrowed.end(), positionIndices.begin(), positionIndices.end());
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * sizeof(GeometryIndex), narrowed.size() * sizeof(GeometryIndex), narrowed.data());
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	this->vertexCount += vertexCount;
+	this->indexCount += indexCount * 2;
+	this->positionCount += positions.size();
+	rangeCount++;
+	return range;
+}
+
+void GeometryHeap::Bind()
+{
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_VERTEX_BINDING, vertexBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_LIGHTMAP_BINDING, lightmapBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_BOUNDS_BINDING, boundsBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_POSITION_BINDING, positionBuffer);
+	GLState::BindVertexArray(VAO);
+}
+
+GeometryRange DepthGeometry(const GeometryRange& range)
+{
+	GeometryRange depth = range;
+	depth.firstVertex = range.firstPosition;
+	depth.vertexCount = range.positionCount;
+	depth.firstIndex = range.firstPositionIndex;
+	return depth;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <GL/glew.h>
+#include "mesh.h"
+#include "vertex_format.h"
+#include "mesh_optimizer.h"
+
+// shader storage bindings of the heap's vertices, lightmap coordinates and
+// quantization bounds, see point_shadows.vs, and of the depth only
+// positions, see point_shadows_depth.vs
+const GLuint GEOMETRY_HEAP_VERTEX_BINDING = 14, GEOMETRY_HEAP_LIGHTMAP_BINDING = 15, GEOMETRY_HEAP_BOUNDS_BINDING = 18;
+const GLuint GEOMETRY_HEAP_POSITION_BINDING = 19;
+
+// indices are relative to their range's first vertex, so 16 bits do for
+// every range up to GEOMETRY_RANGE_MAX_VERTICES; larger meshes are split
+typedef GLushort GeometryIndex;
+const GLenum GEOMETRY_INDEX_TYPE = GL_UNSIGNED_SHORT;
+const GLuint GEOMETRY_RANGE_MAX_VERTICES = 1 << 16;
+
+// where a mesh lives in the heap, firstVertex is the base vertex of its indices
+struct GeometryRange
+{
+	GLuint firstVertex, vertexCount;
+	GLuint firstIndex, indexCount;
+	// the position stream, drawn with indexCount indices as well
+	GLuint firstPosition, positionCount;
+	GLuint firstPositionIndex;
+};
+
+// the range's triangles from the position stream, for passes writing only depth
+GeometryRange DepthGeometry(const GeometryRange& range);
+
+// Sub-allocates the vertices and indices of every mesh from one vertex
+// storage buffer and one index buffer. Vertex shaders fetch their attributes
+// from the storage buffer by gl_VertexID, which includes the base vertex, so
+// a single VAO holding only the index buffer serves every mesh and draws
+// never have to switch vertex buffers or formats. Vertices are stored as
+// PackedVertex, each range quantized against its own bounds. Every range
+// also gets a position stream of PackedPosition, welded by position and
+// with its own indices in the same index buffer, for depth only passes.
+class GeometryHeap
+{
+public:
+	GeometryHeap(GLuint vertexCapacity, GLuint indexCapacity);
+	// vertices without lightmap coordinates get (-1, -1), which point_shadows.frag ignores
+	GeometryRange Allocate(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, const glm::vec2* lightmapCoords = NULL);
+	// binds the vertex storage buffers and the shared VAO
+	void Bind();
+	GLuint VAO;
+	GLuint vertexBuffer, lightmapBuffer, boundsBuffer, positionBuffer, indexBuffer;
+private:
+	GLuint vertexCapacity, indexCapacity;
+	GLuint vertexCount, indexCount, rangeCount, positionCount;
+};
@@ -0,0 +1,215 @@
+#include "gl_backend.h"
+#include "gl_state.h"
+#include "geometry_heap.h"
+#include "instance_culling.h"
+#include "material_table.h"
+#include <iostream>
+#include <cstddef>
+
+GLuint GLBackend::draws = 0;
+
+// uniform blocks of point_shadows_depth_face_instanced.vs, keep in sync with the shader
+const GLuint DEPTH_LIGHT_DATA_BINDING = 1, DEPTH_DRAW_DATA_BINDING = 2;
+struct DepthLightData
+{
+	glm::mat4 shadowMatrices[6];
+	glm::vec3 lightPos;
+	GLfloat far_plane;
+};
+
+GLBackend::GLBackend(StreamBuffer& stream)
+	: stream(stream), depthFaceShader("shaders/point_shadows_depth_face_instanced.vs", "shaders/point_shadows_depth.frag")
+{
+	positions = bounds = indices = instances = NULL_RENDER_HANDLE;
+
+	// the face index never changes, so the six DrawData ranges are written once
+	GLint alignment;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	faceStride = (16 + alignment - 1) / alignment * alignment;
+	vector<GLubyte> faceData(faceStride * 6, 0);
+	for (GLint i = 0; i < 6; i++)
+		*(GLint*)&faceData[i * faceStride] = i;
+	glGenBuffers(1, &faceBuffer);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, faceBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, faceData.size(), faceData.data(), GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+const char* GLBackend::Name() const
+{
+	return "OpenGL 4.3";
+}
+
+// uploads go through the copy target so they never disturb a bound VAO
+RenderHandle GLBackend::CreateBuffer(BufferUsage usage, size_t size, const void* data)
+{
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage == BUFFER_UNIFORM ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return buffer;
+}
+
+void GLBackend::UpdateBuffer(RenderHandle buffer, size_t offset, size_t size, const void* data)
+{
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+RenderHandle GLBackend::CreateTexture(int width, int height, const unsigned char* rgba)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return texture;
+}
+
+RenderHandle GLBackend::CreateDepthCube(int size)
+{
+	DepthCubeTarget target;
+	target.size = size;
+	GLuint cube;
+	glGenTextures(1, &cube);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cube);
+	for (int i = 0; i < 6; i++)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	glGenFramebuffers(1, &target.layered);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.layered);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cube, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		cout << "Framebuffer not complete!" << endl;
+
+	glGenFramebuffers(6, target.faces);
+	for (int i = 0; i < 6; i++)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, target.faces[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cube, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			cout << "Framebuffer not complete!" << endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	depthCubes[cube] = target;
+	return cube;
+}
+
+void GLBackend::SetGeometry(RenderHandle positions, RenderHandle bounds, RenderHandle indices, RenderHandle instances)
+{
+	this->positions = positions;
+	this->bounds = bounds;
+	this->indices = indices;
+	this->instances = instances;
+}
+
+// one draw list per face, the faces share the light's uniform block
+void GLBackend::RenderDepthCube(const DepthCubePass& pass, const vector<BackendDraw> faceDraws[6])
+{
+	DepthCubeTarget& target = depthCubes[pass.target];
+	DepthLightData lightData;
+	for (int i = 0; i < 6; i++)
+		lightData.shadowMatrices[i] = pass.faceMatrices[i];
+	lightData.lightPos = pass.lightPos;
+	lightData.far_plane = pass.farPlane;
+	stream.Bind(GL_UNIFORM_BUFFER, DEPTH_LIGHT_DATA_BINDING, &lightData, sizeof(lightData));
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_POSITION_BINDING, positions);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, GEOMETRY_HEAP_BOUNDS_BINDING, bounds);
+	GLState::BindVertexArray(VertexInput(instances));
+	depthFaceShader.Use();
+
+	glViewport(0, 0, target.size, target.size);
+	for (GLuint i = 0; i < 6; i++)
+	{
+		if ((pass.faceMask & (1 << i)) == 0)
+			continue;
+		glBindFramebuffer(GL_FRAMEBUFFER, target.faces[i]);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		GLState::BindBufferRange(GL_UNIFORM_BUFFER, DEPTH_DRAW_DATA_BINDING, faceBuffer, i * faceStride, 16);
+		for (unsigned int d = 0; d < faceDraws[i].size(); d++)
+		{
+			const BackendDraw& draw = faceDraws[i][d];
+			if (draw.twoSided)
+				GLState::Disable(GL_CULL_FACE);
+			else
+				GLState::Enable(GL_CULL_FACE);
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, draw.indexCount, GEOMETRY_INDEX_TYPE, (GLvoid*)(draw.firstIndex * sizeof(GeometryIndex)),
+				draw.instanceCount, draw.baseVertex, draw.firstInstance);
+			draws++;
+		}
+	}
+	GLState::Enable(GL_CULL_FACE);
+}
+
+void GLBackend::ReadDepthFace(RenderHandle cube, int face, vector<float>& depths)
+{
+	depths.resize(depthCubes[cube].size * depthCubes[cube].size);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cube);
+	glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data());
+}
+
+GLuint GLBackend::LayeredFramebuffer(RenderHandle cube)
+{
+	return depthCubes[cube].layered;
+}
+
+GLuint GLBackend::FaceFramebuffer(RenderHandle cube, GLuint face)
+{
+	return depthCubes[cube].faces[face];
+}
+
+// vertices are pulled from the vertex storage buffer by gl_VertexID, so the
+// VAO only holds the index buffer and the per instance attributes
+GLuint GLBackend::VertexInput(RenderHandle instanceBuffer)
+{
+	map<RenderHandle, GLuint>::iterator found = vertexInputs.find(instanceBuffer);
+	if (found != vertexInputs.end())
+		return found->second;
+
+	GLuint VAO;
+	glGenVertexArrays(1, &VAO);
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(3 + column);
+		glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(3 + column, 1);
+	}
+	for (GLuint column = 0; column < 3; column++)
+	{
+		glEnableVertexAttribArray(7 + column);
+		glVertexAttribPointer(7 + column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (GLvoid*)(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+		glVertexAttribDivisor(7 + column, 1);
+	}
+	glEnableVertexAttribArray(10);
+	glVertexAttribIPointer(10, 1, GL_INT, sizeof(InstanceData), (GLvoid*)offsetof(InstanceData, lightmapTile));
+	glVertexAttribDivisor(10, 1);
+	glEnableVertexAttribArray(MATERIAL_ATTRIBUTE);
+	glVertexAttribIPointer(MATERIAL_ATTRIBUTE, 1, GL_INT, sizeof(InstanceData), (GLvoid*)offsetof(InstanceData, material));
+	glVertexAttribDivisor(MATERIAL_ATTRIBUTE, 1);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindVertexArray(0);
+
+	vertexInputs[instanceBuffer] = VAO;
+	return VAO;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <GL/glew.h>
+#include "render_backend.h"
+#include "shader.h"
+#include "stream_buffer.h"
+
+using namespace std;
+
+// RenderBackend over OpenGL 4.3. Handles are GL object names, so the shadow
+// techniques that only exist in GL keep drawing into the same textures and
+// framebuffers through the accessors below.
+class GLBackend : public RenderBackend
+{
+public:
+	// the depth cube pass streams its light data through the frame's stream buffer
+	GLBackend(StreamBuffer& stream);
+	const char* Name() const;
+	RenderHandle CreateBuffer(BufferUsage usage, size_t size, const void* data);
+	void UpdateBuffer(RenderHandle buffer, size_t offset, size_t size, const void* data);
+	RenderHandle CreateTexture(int width, int height, const unsigned char* rgba);
+	RenderHandle CreateDepthCube(int size);
+	void SetGeometry(RenderHandle positions, RenderHandle bounds, RenderHandle indices, RenderHandle instances);
+	void RenderDepthCube(const DepthCubePass& pass, const vector<BackendDraw> faceDraws[6]);
+	void ReadDepthFace(RenderHandle cube, int face, vector<float>& depths);
+
+	// framebuffers of a depth cube, all six layers or a single face
+	GLuint LayeredFramebuffer(RenderHandle cube);
+	GLuint FaceFramebuffer(RenderHandle cube, GLuint face);
+	// a VAO binding the geometry's index buffer and the InstanceData
+	// attributes of an instance buffer, made once per instance buffer
+	GLuint VertexInput(RenderHandle instanceBuffer);
+
+	// draws issued by RenderDepthCube, reset by whoever reports them
+	static GLuint draws;
+private:
+	struct DepthCubeTarget
+	{
+		int size;
+		GLuint layered;
+		GLuint faces[6];
+	};
+	map<RenderHandle, DepthCubeTarget> depthCubes;
+	map<RenderHandle, GLuint> vertexInputs;
+	RenderHandle positions, bounds, indices, instances;
+	StreamBuffer& stream;
+	Shader depthFaceShader;
+	// the six per face DrawData ranges
+	GLuint faceBuffer;
+	GLint faceStride;
+};
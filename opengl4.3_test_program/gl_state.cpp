@@ -0,0 +1,135 @@
+#include "gl_state.h"
+
+// no GL name is this large, so it marks state that has not been set yet
+const GLuint UNKNOWN_BINDING = 0xFFFFFFFF;
+
+GLuint GLState::issued = 0;
+GLuint GLState::elided = 0;
+GLuint GLState::program = UNKNOWN_BINDING;
+GLuint GLState::vertexArray = UNKNOWN_BINDING;
+GLenum GLState::activeTexture = UNKNOWN_BINDING;
+map<GLenum, GLuint> GLState::buffers;
+map<pair<GLenum, GLuint>, GLuint> GLState::indexedBuffers;
+map<pair<GLenum, GLenum>, GLuint> GLState::textures;
+map<GLenum, bool> GLState::capabilities;
+
+bool GLState::Changed(bool changed)
+{
+	if (changed)
+		issued++;
+	else
+		elided++;
+	return changed;
+}
+
+void GLState::UseProgram(GLuint program)
+{
+	if (Changed(GLState::program != program))
+	{
+		GLState::program = program;
+		glUseProgram(program);
+	}
+}
+
+void GLState::BindVertexArray(GLuint vertexArray)
+{
+	if (Changed(GLState::vertexArray != vertexArray))
+	{
+		GLState::vertexArray = vertexArray;
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer)
+{
+	// the element array binding belongs to the bound VAO, so it is never cached
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	map<GLenum, GLuint>::iterator it = buffers.find(target);
+	if (Changed(it == buffers.end() || it->second != buffer))
+	{
+		buffers[target] = buffer;
+		glBindBuffer(target, buffer);
+	}
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	map<pair<GLenum, GLuint>, GLuint>::iterator it = indexedBuffers.find(make_pair(target, index));
+	if (Changed(it == indexedBuffers.end() || it->second != buffer))
+	{
+		indexedBuffers[make_pair(target, index)] = buffer;
+		glBindBufferBase(target, index, buffer);
+	}
+	// binding an indexed target also replaces the generic binding
+	buffers[target] = buffer;
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	// ranges move every frame, only remember that the index no longer holds a whole buffer
+	issued++;
+	indexedBuffers[make_pair(target, index)] = UNKNOWN_BINDING;
+	buffers[target] = buffer;
+	glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLState::DeleteBuffer(GLuint buffer)
+{
+	for (map<GLenum, GLuint>::iterator it = buffers.begin(); it != buffers.end(); ++it)
+	{
+		if (it->second == buffer)
+			it->second = 0;
+	}
+	// ranges are cached as unknown, a reused name must not match those either
+	for (map<pair<GLenum, GLuint>, GLuint>::iterator it = indexedBuffers.begin(); it != indexedBuffers.end(); ++it)
+	{
+		if (it->second == buffer)
+			it->second = 0;
+	}
+	glDeleteBuffers(1, &buffer);
+}
+
+void GLState::ActiveTexture(GLenum unit)
+{
+	if (Changed(activeTexture != unit))
+	{
+		activeTexture = unit;
+		glActiveTexture(unit);
+	}
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture)
+{
+	pair<GLenum, GLenum> key(activeTexture, target);
+	map<pair<GLenum, GLenum>, GLuint>::iterator it = textures.find(key);
+	if (Changed(activeTexture == UNKNOWN_BINDING || it == textures.end() || it->second != texture))
+	{
+		textures[key] = texture;
+		glBindTexture(target, texture);
+	}
+}
+
+void GLState::Enable(GLenum capability)
+{
+	map<GLenum, bool>::iterator it = capabilities.find(capability);
+	if (Changed(it == capabilities.end() || !it->second))
+	{
+		capabilities[capability] = true;
+		glEnable(capability);
+	}
+}
+
+void GLState::Disable(GLenum capability)
+{
+	map<GLenum, bool>::iterator it = capabilities.find(capability);
+	if (Changed(it == capabilities.end() || it->second))
+	{
+		capabilities[capability] = false;
+		glDisable(capability);
+	}
+}
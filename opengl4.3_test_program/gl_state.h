@@ -0,0 +1,39 @@
+#pragma once
+#include <map>
+#include <utility>
+#include <GL/glew.h>
+
+using namespace std;
+
+// Thin cache over the binding and capability calls the renderer makes every
+// frame. Each wrapper mirrors the GL call it replaces and skips it when the
+// cached state already matches. Every bind in the program must go through
+// here, otherwise the cache goes stale.
+class GLState
+{
+public:
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vertexArray);
+	static void BindBuffer(GLenum target, GLuint buffer);
+	static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	// GL resets every binding of a deleted buffer to zero, and may hand its name out again
+	static void DeleteBuffer(GLuint buffer);
+	static void ActiveTexture(GLenum unit);
+	static void BindTexture(GLenum target, GLuint texture);
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+
+	// calls passed on to GL and calls skipped, reset by whoever reports them
+	static GLuint issued;
+	static GLuint elided;
+private:
+	static GLuint program;
+	static GLuint vertexArray;
+	static GLenum activeTexture;
+	static map<GLenum, GLuint> buffers;
+	static map<pair<GLenum, GLuint>, GLuint> indexedBuffers;
+	static map<pair<GLenum, GLenum>, GLuint> textures;
+	static map<GLenum, bool> capabilities;
+	static bool Changed(bool changed);
+};
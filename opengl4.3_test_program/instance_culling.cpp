@@ -0,0 +1,86 @@
+#include "instance_culling.h"
+#include "gl_state.h"
+#include "glm/gtc/type_ptr.hpp"
+
+// set on instances of static batches in the batch index buffer
+const GLuint STATIC_BATCH_BIT = 0x80000000;
+
+InstanceCuller::InstanceCuller(StreamBuffer& stream)
+	: cullShader("shaders/instance_culling.comp"), stream(stream)
+{
+	instanceBuffer = 0;
+	instanceCount = 0;
+	commandOffset = 0;
+	glGenBuffers(1, &visibleBuffer);
+	glGenBuffers(1, &batchIndexBuffer);
+	glGenBuffers(1, &batchBoundsBuffer);
+}
+
+void InstanceCuller::Setup(GLuint instanceBuffer, const vector<InstanceBatch>& batches)
+{
+	this->instanceBuffer = instanceBuffer;
+
+	vector<GLuint> batchIndex;
+	vector<glm::vec4> batchBounds;
+	commands.clear();
+	depthCommands.clear();
+	for (GLuint i = 0; i < batches.size(); i++)
+	{
+		for (GLuint j = 0; j < batches[i].count; j++)
+			batchIndex.push_back(i | (batches[i].isStatic ? STATIC_BATCH_BIT : 0));
+
+		// survivors of a batch are compacted into the batch's own range
+		DrawElementsIndirectCommand command;
+		command.count = batches[i].geometry.indexCount;
+		command.instanceCount = 0;
+		command.firstIndex = batches[i].geometry.firstIndex;
+		command.baseVertex = batches[i].geometry.firstVertex;
+		command.baseInstance = batches[i].first;
+		commands.push_back(command);
+		GeometryRange depth = DepthGeometry(batches[i].geometry);
+		command.firstIndex = depth.firstIndex;
+		command.baseVertex = depth.firstVertex;
+		depthCommands.push_back(command);
+		batchBounds.push_back(batches[i].meshBounds);
+	}
+	instanceCount = batchIndex.size();
+
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, batchIndexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, batchIndex.size() * sizeof(GLuint), batchIndex.data(), GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, batchBoundsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, batchBounds.size() * sizeof(glm::vec4), batchBounds.data(), GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLState::BindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(InstanceData), NULL, GL_DYNAMIC_COPY);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceCuller::Cull(const glm::mat4& viewProjection, bool dynamicOnly, bool depthOnly)
+{
+	if (instanceCount == 0)
+		return;
+
+	// zeroed commands for the compute shader to count survivors into
+	GLsizeiptr commandSize = commands.size() * sizeof(DrawElementsIndirectCommand);
+	commandOffset = stream.Write(depthOnly ? depthCommands.data() : commands.data(), commandSize);
+
+	cullShader.Use();
+	cullShader.SetMat4("viewProjection", viewProjection);
+	cullShader.SetUint("instanceCount", instanceCount);
+	cullShader.SetInt("dynamicOnly", dynamicOnly);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, instanceBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, batchIndexBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, batchBoundsBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, visibleBuffer);
+	GLState::BindBufferRange(GL_SHADER_STORAGE_BUFFER, 13, stream.buffer, commandOffset, commandSize);
+	glDispatchCompute((instanceCount + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void InstanceCuller::Draw(GLuint firstBatch, GLuint batchCount)
+{
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.buffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GEOMETRY_INDEX_TYPE, (void*)(commandOffset + firstBatch * sizeof(DrawElementsIndirectCommand)), batchCount, 0);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "shadow_binning.h"
+#include "stream_buffer.h"
+#include "geometry_heap.h"
+
+using namespace std;
+
+// per instance vertex attributes at locations 3-11, see point_shadows.vs
+struct InstanceData
+{
+	glm::mat4 model;
+	glm::mat3 normalMatrix;
+	GLint lightmapTile;
+	// index into the bindless material table
+	GLint material;
+};
+
+// a contiguous range of instances of one mesh sharing render state
+struct InstanceBatch
+{
+	GLuint first, count;
+	bool reverse_normals;
+	bool isStatic;
+	GLuint texture;
+	GeometryRange geometry;
+	// object space bounding sphere of the mesh, xyz center and w radius
+	glm::vec4 meshBounds;
+	// bounding sphere of every instance in the batch
+	glm::vec3 center;
+	GLfloat radius;
+};
+
+// Frustum culls instances in a compute shader and compacts the survivors of
+// every batch into a visible instance buffer, with one indexed indirect
+// command per batch. A pass is then one dispatch plus one multi-draw,
+// whatever the instance count. The per-pass command reset is streamed, so
+// successive culls in a frame never wait on each other's draws.
+class InstanceCuller
+{
+public:
+	InstanceCuller(StreamBuffer& stream);
+	void Setup(GLuint instanceBuffer, const vector<InstanceBatch>& batches);
+	// depthOnly passes draw the position streams, see DepthGeometry
+	void Cull(const glm::mat4& viewProjection, bool dynamicOnly, bool depthOnly);
+	// the visible instance buffer must be bound as the instanced attribute stream
+	// and the geometry heap's index buffer as the element array
+	void Draw(GLuint firstBatch, GLuint batchCount);
+	GLuint visibleBuffer;
+private:
+	Shader cullShader;
+	StreamBuffer& stream;
+	GLuint instanceBuffer, batchIndexBuffer, batchBoundsBuffer;
+	// offset of the last culled commands in the stream buffer
+	GLintptr commandOffset;
+	GLuint instanceCount;
+	vector<DrawElementsIndirectCommand> commands, depthCommands;
+};
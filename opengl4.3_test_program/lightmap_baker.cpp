@@ -0,0 +1,225 @@
+#include "lightmap_baker.h"
+#include "gl_state.h"
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "bvh.h"
+
+const unsigned int LIGHTMAP_CACHE_VERSION = 1;
+const int LIGHTMAP_SAMPLES = 2;
+
+int CubeFace(glm::vec3 normal)
+{
+	glm::vec3 a = glm::abs(normal);
+	int axis = 0;
+	if (a.y > a[axis])
+		axis = 1;
+	if (a.z > a[axis])
+		axis = 2;
+	return axis * 2 + (normal[axis] < 0.0f ? 1 : 0);
+}
+
+LightmapBaker::LightmapBaker(GLuint tileSize)
+{
+	this->tileSize = tileSize;
+	tileCount = 0;
+	tilesPerRow = 0;
+	lightmap = 0;
+}
+
+int LightmapBaker::AddStaticMesh(const vector<glm::vec3>& positions, const vector<glm::vec2>& uvs, const vector<int>& triangleCharts, GLuint chartCount)
+{
+	int firstTile = tileCount;
+	for (unsigned int t = 0; t < triangleCharts.size(); t++)
+	{
+		StaticTriangle triangle;
+		for (int k = 0; k < 3; k++)
+		{
+			triangle.positions[k] = positions[t * 3 + k];
+			triangle.uvs[k] = uvs[t * 3 + k];
+		}
+		triangle.tile = firstTile + triangleCharts[t];
+		triangles.push_back(triangle);
+	}
+	tileCount += chartCount;
+	return firstTile;
+}
+
+unsigned long long LightmapBaker::Hash(glm::vec3 lightPos)
+{
+	// FNV-1a over everything that changes the baked result
+	unsigned long long hash = 14695981039346656037ULL;
+	const unsigned char* bytes = (const unsigned char*)&triangles[0];
+	for (size_t i = 0; i < triangles.size() * sizeof(StaticTriangle); i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	bytes = (const unsigned char*)&lightPos[0];
+	for (size_t i = 0; i < sizeof(glm::vec3); i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	hash = (hash ^ tileSize) * 1099511628211ULL;
+	hash = (hash ^ LIGHTMAP_SAMPLES) * 1099511628211ULL;
+	return hash;
+}
+
+bool LightmapBaker::LoadCache(const string& cachePath, unsigned long long hash)
+{
+	ifstream file(cachePath.c_str(), ios::binary);
+	if (!file)
+		return false;
+	unsigned int version = 0;
+	unsigned long long fileHash = 0;
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&fileHash, sizeof(fileHash));
+	if (!file || version != LIGHTMAP_CACHE_VERSION || fileHash != hash)
+		return false;
+	file.read((char*)&texels[0], texels.size());
+	return (bool)file;
+}
+
+void LightmapBaker::SaveCache(const string& cachePath, unsigned long long hash)
+{
+	ofstream file(cachePath.c_str(), ios::binary);
+	if (!file)
+	{
+		cout << "ERROR::LIGHTMAP::CACHE_NOT_WRITTEN " << cachePath << endl;
+		return;
+	}
+	file.write((const char*)&LIGHTMAP_CACHE_VERSION, sizeof(LIGHTMAP_CACHE_VERSION));
+	file.write((const char*)&hash, sizeof(hash));
+	file.write((const char*)&texels[0], texels.size());
+}
+
+void LightmapBaker::Bake(glm::vec3 lightPos, const string& cachePath)
+{
+	tilesPerRow = (GLuint)ceil(sqrt((float)tileCount));
+	GLuint atlasSize = tilesPerRow * tileSize;
+	texels.assign(atlasSize * atlasSize, 0);
+
+	unsigned long long hash = Hash(lightPos);
+	if (LoadCache(cachePath, hash))
+	{
+		cout << "lightmap loaded from " << cachePath << endl;
+	}
+	else
+	{
+		vector<glm::vec4> trianglePositions;
+		vector<vector<GLuint> > tileTriangles(tileCount);
+		for (unsigned int t = 0; t < triangles.size(); t++)
+		{
+			for (int k = 0; k < 3; k++)
+				trianglePositions.push_back(glm::vec4(triangles[t].positions[k], 1.0f));
+			tileTriangles[triangles[t].tile].push_back(t);
+		}
+		BVH bvh(trianglePositions);
+
+		atomic<GLuint> nextTile(0);
+		auto worker = [&]()
+		{
+			vector<float> tile(tileSize * tileSize);
+			vector<bool> covered(tileSize * tileSize);
+			for (GLuint t = nextTile++; t < tileCount; t = nextTile++)
+			{
+				fill(covered.begin(), covered.end(), false);
+				for (GLuint y = 0; y < tileSize; y++)
+				{
+					for (GLuint x = 0; x < tileSize; x++)
+					{
+						// texel centers sit on the uv grid so bilinear filtering never leaves the tile
+						float shadow = 0.0f;
+						int samples = 0;
+						for (int sy = 0; sy < LIGHTMAP_SAMPLES; sy++)
+						{
+							for (int sx = 0; sx < LIGHTMAP_SAMPLES; sx++)
+							{
+								glm::vec2 jitter = (glm::vec2(sx, sy) + 0.5f) / (float)LIGHTMAP_SAMPLES - 0.5f;
+								glm::vec2 uv = glm::clamp((glm::vec2(x, y) + jitter) / (float)(tileSize - 1), 0.0f, 1.0f);
+								for (unsigned int i = 0; i < tileTriangles[t].size(); i++)
+								{
+									const StaticTriangle& triangle = triangles[tileTriangles[t][i]];
+									glm::vec2 e0 = triangle.uvs[1] - triangle.uvs[0];
+									glm::vec2 e1 = triangle.uvs[2] - triangle.uvs[0];
+									glm::vec2 e2 = uv - triangle.uvs[0];
+									float det = e0.x * e1.y - e0.y * e1.x;
+									if (fabs(det) < 1e-12f)
+										continue;
+									float b1 = (e2.x * e1.y - e2.y * e1.x) / det;
+									float b2 = (e0.x * e2.y - e0.y * e2.x) / det;
+									if (b1 < -1e-4f || b2 < -1e-4f || b1 + b2 > 1.0f + 1e-4f)
+										continue;
+
+									glm::vec3 p = triangle.positions[0] + b1 * (triangle.positions[1] - triangle.positions[0]) + b2 * (triangle.positions[2] - triangle.positions[0]);
+									glm::vec3 normal = glm::normalize(glm::cross(triangle.positions[1] - triangle.positions[0], triangle.positions[2] - triangle.positions[0]));
+									glm::vec3 toLight = lightPos - p;
+									if (glm::dot(normal, toLight) < 0.0f)
+										normal = -normal;
+									glm::vec3 origin = p + normal * 0.01f;
+									toLight = lightPos - origin;
+									float distance = glm::length(toLight);
+									if (bvh.Occluded(origin, toLight / distance, distance))
+										shadow += 1.0f;
+									samples++;
+									break;
+								}
+							}
+						}
+						if (samples > 0)
+						{
+							tile[y * tileSize + x] = shadow / samples;
+							covered[y * tileSize + x] = true;
+						}
+					}
+				}
+
+				// grow covered texels into uncovered neighbours to hide chart borders
+				GLuint tileX = (t % tilesPerRow) * tileSize;
+				GLuint tileY = (t / tilesPerRow) * tileSize;
+				for (GLuint y = 0; y < tileSize; y++)
+				{
+					for (GLuint x = 0; x < tileSize; x++)
+					{
+						float value = tile[y * tileSize + x];
+						if (!covered[y * tileSize + x])
+						{
+							for (int dy = -1; dy <= 1; dy++)
+								for (int dx = -1; dx <= 1; dx++)
+								{
+									int nx = x + dx, ny = y + dy;
+									if (nx >= 0 && ny >= 0 && nx < (int)tileSize && ny < (int)tileSize && covered[ny * tileSize + nx])
+										value = tile[ny * tileSize + nx];
+								}
+						}
+						texels[(tileY + y) * atlasSize + tileX + x] = (unsigned char)(value * 255.0f + 0.5f);
+					}
+				}
+			}
+		};
+
+		unsigned int threadCount = glm::max(thread::hardware_concurrency(), 1u);
+		vector<thread> threads;
+		for (unsigned int i = 0; i < threadCount; i++)
+			threads.push_back(thread(worker));
+		for (unsigned int i = 0; i < threadCount; i++)
+			threads[i].join();
+
+		cout << "lightmap baked: " << tileCount << " tiles on " << threadCount << " threads" << endl;
+		SaveCache(cachePath, hash);
+	}
+
+	glGenTextures(1, &lightmap);
+	GLState::BindTexture(GL_TEXTURE_2D, lightmap);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasSize, atlasSize, 0, GL_RED, GL_UNSIGNED_BYTE, &texels[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+glm::vec2 LightmapBaker::AtlasCoords(GLuint tile, glm::vec2 uv) const
+{
+	glm::vec2 origin = glm::vec2(tile % tilesPerRow, tile / tilesPerRow) * (float)tileSize;
+	return (origin + 0.5f + uv * (tileSize - 1.0f)) / (float)(tilesPerRow * tileSize);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+
+using namespace std;
+
+// cube map face order (+X, -X, +Y, -Y, +Z, -Z) of an axis aligned normal,
+// used as the lightmap chart of a cube face; point_shadows.vs does the same
+int CubeFace(glm::vec3 normal);
+
+// Bakes point light visibility of static geometry into a lightmap atlas on
+// worker threads. Every chart of a mesh gets its own square tile; the result
+// is cached on disk and only rebaked when the geometry or the light changes.
+class LightmapBaker
+{
+public:
+	LightmapBaker(GLuint tileSize);
+	int AddStaticMesh(const vector<glm::vec3>& positions, const vector<glm::vec2>& uvs, const vector<int>& triangleCharts, GLuint chartCount);
+	void Bake(glm::vec3 lightPos, const string& cachePath);
+	// atlas coordinates of a uv inside a tile, valid after Bake; point_shadows.vs does the same
+	glm::vec2 AtlasCoords(GLuint tile, glm::vec2 uv) const;
+	GLuint lightmap;
+	GLuint tileSize, tilesPerRow;
+private:
+	struct StaticTriangle
+	{
+		glm::vec3 positions[3];
+		glm::vec2 uvs[3];
+		GLuint tile;
+	};
+	vector<StaticTriangle> triangles;
+	GLuint tileCount;
+	vector<unsigned char> texels;
+	unsigned long long Hash(glm::vec3 lightPos);
+	bool LoadCache(const string& cachePath, unsigned long long hash);
+	void SaveCache(const string& cachePath, unsigned long long hash);
+};
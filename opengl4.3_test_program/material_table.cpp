@@ -0,0 +1,41 @@
+#include "material_table.h"
+#include "gl_state.h"
+
+MaterialTable::MaterialTable()
+{
+	dirty = false;
+	glGenBuffers(1, &buffer);
+}
+
+bool MaterialTable::Supported()
+{
+	return GLEW_ARB_bindless_texture != 0;
+}
+
+GLint MaterialTable::Add(GLuint texture)
+{
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		if (textures[i] == texture)
+			return i;
+	}
+	// the texture's sampler state is frozen once a handle exists
+	GLuint64 handle = glGetTextureHandleARB(texture);
+	glMakeTextureHandleResidentARB(handle);
+	textures.push_back(texture);
+	handles.push_back(handle);
+	dirty = true;
+	return textures.size() - 1;
+}
+
+void MaterialTable::Bind()
+{
+	if (dirty)
+	{
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, handles.size() * sizeof(GLuint64), handles.data(), GL_STATIC_DRAW);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		dirty = false;
+	}
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIAL_TABLE_BINDING, buffer);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+
+using namespace std;
+
+// shader storage binding of the handles and the instance attribute holding
+// the material index, see point_shadows.frag and point_shadows.vs
+const GLuint MATERIAL_TABLE_BINDING = 17, MATERIAL_ATTRIBUTE = 11;
+
+// Keeps one resident ARB_bindless_texture handle per material in a storage
+// buffer. Draws only carry a material index, so no texture has to be bound
+// between them and draws of different materials can share one multi-draw.
+class MaterialTable
+{
+public:
+	MaterialTable();
+	static bool Supported();
+	// returns the material index of a diffuse texture, adding it on first use
+	GLint Add(GLuint texture);
+	// uploads added handles and binds the table
+	void Bind();
+	GLuint buffer;
+private:
+	vector<GLuint> textures;
+	vector<GLuint64> handles;
+	bool dirty;
+};
@@ -1,46 +1,118 @@
 #include "mesh.h"
+#include "gl_state.h"
+#include "geometry_heap.h"
+#include "material_table.h"
+#include <map>
+#include <tuple>
 
-Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, GeometryHeap& heap)
 {
 	this->vertices = vertices;
 	this->indices = indices;
 	this->textures = textures;
+	this->heap = &heap;
+	this->material = -1;
 
 	setupMesh();
 }
 
 void Mesh::setupMesh()
 {
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
+	GeometryRange range = heap->Allocate(&vertices[0], vertices.size(), &indices[0], indices.size());
+	firstVertex = range.firstVertex;
+	firstIndex = range.firstIndex;
+	firstPosition = range.firstPosition;
+	firstPositionIndex = range.firstPositionIndex;
+	positionCount = range.positionCount;
 
-	glBindVertexArray(VAO);
+	vector<glm::vec3> positions;
+	for (unsigned int i = 0; i < vertices.size(); i++)
+		positions.push_back(vertices[i].Positon);
+	BuildEdgeAdjacency(positions, indices, edges);
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+void BuildEdgeAdjacency(const vector<glm::vec3>& positions, const vector<unsigned int>& indices, vector<Edge>& edges)
+{
+	// weld vertices by position so edges split by normals or uvs still match up
+	map<tuple<float, float, float>, unsigned int> weldMap;
+	vector<unsigned int> welded(positions.size());
+	for (unsigned int i = 0; i < positions.size(); i++)
+	{
+		tuple<float, float, float> key(positions[i].x, positions[i].y, positions[i].z);
+		map<tuple<float, float, float>, unsigned int>::iterator it = weldMap.find(key);
+		if (it == weldMap.end())
+		{
+			welded[i] = weldMap.size();
+			weldMap[key] = welded[i];
+		}
+		else
+			welded[i] = it->second;
+	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	map<pair<unsigned int, unsigned int>, unsigned int> edgeMap;
+	for (unsigned int t = 0; t + 2 < indices.size(); t += 3)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned int v0 = indices[t + k];
+			unsigned int v1 = indices[t + (k + 1) % 3];
+			unsigned int opposite = indices[t + (k + 2) % 3];
+			if (welded[v0] == welded[v1])
+				continue;
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+			pair<unsigned int, unsigned int> key(min(welded[v0], welded[v1]), max(welded[v0], welded[v1]));
+			map<pair<unsigned int, unsigned int>, unsigned int>::iterator it = edgeMap.find(key);
+			if (it == edgeMap.end())
+			{
+				Edge edge;
+				edge.v0 = v0;
+				edge.v1 = v1;
+				edge.oppositeA = opposite;
+				edge.oppositeB = NO_ADJACENT_TRIANGLE;
+				edgeMap[key] = edges.size();
+				edges.push_back(edge);
+			}
+			else
+			{
+				Edge& edge = edges[it->second];
+				if (edge.oppositeB == NO_ADJACENT_TRIANGLE && welded[edge.v0] == welded[v1])
+					edge.oppositeB = opposite;
+			}
+		}
+	}
+}
 
-	//glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+// The heap VAO has no instance arrays, so the instanced attributes of
+// point_shadows.vs read their current generic values: an untransformed
+// instance without a lightmap tile.
+static void SetIdentityInstance(GLint material)
+{
+	glm::mat4 model(1.0f);
+	for (GLuint column = 0; column < 4; column++)
+		glVertexAttrib4fv(3 + column, &model[column][0]);
+	glm::mat3 normalMatrix(1.0f);
+	for (GLuint column = 0; column < 3; column++)
+		glVertexAttrib3fv(7 + column, &normalMatrix[column][0]);
+	glVertexAttribI1i(10, -1);
+	glVertexAttribI1i(MATERIAL_ATTRIBUTE, material);
 }
 
-void Mesh::Draw(Shader shader)
+void Mesh::Draw(Shader& shader)
 {
+	shader.Use();
+	if (material >= 0)
+	{
+		SetIdentityInstance(material);
+		heap->Bind();
+		glDrawElementsBaseVertex(GL_TRIANGLES, indices.size(), GEOMETRY_INDEX_TYPE, (void*)(firstIndex * sizeof(GeometryIndex)), firstVertex);
+		return;
+	}
+
 	unsigned int diffuseNr = 0;
 	unsigned int specularNr = 0;
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
+		GLState::ActiveTexture(GL_TEXTURE0 + i);
 		string number;
 		string name = textures[i].type;
 		if (name == "texture_diffuse")
@@ -51,13 +123,22 @@ void Mesh::Draw(Shader shader)
 		{
 			number = std::to_string(specularNr++);
 		}
-		shader.Use();
-		glUniform1i(glGetUniformLocation(shader.Program, ("material." + name + number).c_str()), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+		shader.SetInt("material." + name + number, i);
+		GLState::BindTexture(GL_TEXTURE_2D, textures[i].id);
 	}
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	// the bound textures are used, the material index is ignored
+	SetIdentityInstance(0);
+	heap->Bind();
+	glDrawElementsBaseVertex(GL_TRIANGLES, indices.size(), GEOMETRY_INDEX_TYPE, (void*)(firstIndex * sizeof(GeometryIndex)), firstVertex);
+
+	GLState::ActiveTexture(GL_TEXTURE0);
+}
 
-	glActiveTexture(GL_TEXTURE0);
+void Mesh::DrawDepth(Shader& shader)
+{
+	shader.Use();
+	SetIdentityInstance(0);
+	heap->Bind();
+	// the position stream has its own indices, as many as the full range
+	glDrawElementsBaseVertex(GL_TRIANGLES, indices.size(), GEOMETRY_INDEX_TYPE, (void*)(firstPositionIndex * sizeof(GeometryIndex)), firstPosition);
 }
\ No newline at end of file
@@ -10,6 +10,9 @@
 #include <assimp/postprocess.h>
 #include "shader.h"
 
+class GeometryHeap;
+class MaterialTable;
+
 using namespace std;
 
 struct Vertex 
@@ -19,6 +22,18 @@ struct Vertex
 	glm::vec2 TexCoords;
 };
 
+// v0 -> v1 follows the winding of the first triangle sharing the edge,
+// oppositeA/oppositeB are the third corners of the two triangles
+struct Edge
+{
+	unsigned int v0, v1;
+	unsigned int oppositeA, oppositeB;
+};
+
+const unsigned int NO_ADJACENT_TRIANGLE = 0xFFFFFFFF;
+
+void BuildEdgeAdjacency(const vector<glm::vec3>& positions, const vector<unsigned int>& indices, vector<Edge>& edges);
+
 struct Texture
 {
 	unsigned int id;
@@ -32,10 +47,18 @@ public:
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
 	vector<Texture> textures;
+	vector<Edge> edges;
 	
-	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures);
-	void Draw(Shader shader);
-	unsigned int VAO, VBO, EBO;
+	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, GeometryHeap& heap);
+	void Draw(Shader& shader);
+	// draws the position stream with a depth only shader, see DepthGeometry
+	void DrawDepth(Shader& shader);
+	// the vertices are pulled packed from the heap's storage buffer, see GeometryHeap
+	GeometryHeap* heap;
+	GLuint firstVertex, firstIndex;
+	GLuint firstPosition, firstPositionIndex, positionCount;
+	// index into the bindless material table, -1 binds the textures instead
+	GLint material;
 private:
 	void setupMesh();
 };
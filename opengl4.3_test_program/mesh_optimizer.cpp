@@ -0,0 +1,320 @@
+#include "mesh_optimizer.h"
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+// FIFO post-transform cache: a vertex is cached while fewer than cacheSize
+// misses happened since its own, and Reset forgets everything
+struct FifoCache
+{
+	vector<GLuint> missedAt;
+	GLuint misses, resetAt, cacheSize;
+	FifoCache(GLuint vertexCount, GLuint cacheSize) : missedAt(vertexCount, 0), misses(0), resetAt(0), cacheSize(cacheSize) {}
+	// true when the vertex had to be transformed
+	bool Access(GLuint v)
+	{
+		if (missedAt[v] > resetAt && misses - missedAt[v] < cacheSize)
+			return false;
+		misses++;
+		missedAt[v] = misses;
+		return true;
+	}
+	void Reset()
+	{
+		resetAt = misses;
+	}
+};
+
+float MeshStats::ACMR() const
+{
+	return triangles > 0 ? transformed / (float)triangles : 0.0f;
+}
+
+float MeshStats::ATVR() const
+{
+	return vertices > 0 ? transformed / (float)vertices : 0.0f;
+}
+
+MeshStats MeasureMesh(const vector<GLuint>& indices, GLuint vertexCount, GLuint cacheSize)
+{
+	MeshStats stats;
+	stats.triangles = indices.size() / 3;
+	stats.vertices = 0;
+	vector<bool> used(vertexCount, false);
+	FifoCache cache(vertexCount, cacheSize);
+	for (unsigned int i = 0; i < indices.size(); i++)
+	{
+		if (!used[indices[i]])
+			stats.vertices++;
+		used[indices[i]] = true;
+		cache.Access(indices[i]);
+	}
+	stats.transformed = cache.misses;
+	return stats;
+}
+
+// Vertex is eight floats without padding, so its bytes are its identity
+GLuint WeldVertices(vector<Vertex>& vertices, vector<GLuint>& indices)
+{
+	unordered_map<string, GLuint> unique;
+	vector<GLuint> remap(vertices.size());
+	vector<Vertex> welded;
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		string key((const char*)&vertices[i], sizeof(Vertex));
+		unordered_map<string, GLuint>::iterator found = unique.find(key);
+		if (found == unique.end())
+		{
+			remap[i] = welded.size();
+			unique[key] = welded.size();
+			welded.push_back(vertices[i]);
+		}
+		else
+			remap[i] = found->second;
+	}
+	for (unsigned int i = 0; i < indices.size(); i++)
+		indices[i] = remap[indices[i]];
+	GLuint removed = vertices.size() - welded.size();
+	vertices.swap(welded);
+	return removed;
+}
+
+static float VertexScore(GLint cachePosition, GLuint remainingTriangles)
+{
+	// no triangle left to add, the vertex no longer matters
+	if (remainingTriangles == 0)
+		return -1.0f;
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// the last triangle's vertices score the same so its orientation does not matter
+		if (cachePosition < 3)
+			score = 0.75f;
+		else
+			score = pow(1.0f - (cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3), 1.5f);
+	}
+	return score + 2.0f / sqrt((float)remainingTriangles);
+}
+
+void OptimizeVertexCache(vector<GLuint>& indices, GLuint vertexCount)
+{
+	GLuint triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// triangles of every vertex, the ones still to add first
+	vector<GLuint> remaining(vertexCount, 0);
+	for (unsigned int i = 0; i < indices.size(); i++)
+		remaining[indices[i]]++;
+	vector<GLuint> adjacencyOffset(vertexCount + 1, 0);
+	for (GLuint v = 0; v < vertexCount; v++)
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+	vector<GLuint> adjacency(indices.size());
+	vector<GLuint> filled(vertexCount, 0);
+	for (unsigned int i = 0; i < indices.size(); i++)
+		adjacency[adjacencyOffset[indices[i]] + filled[indices[i]]++] = i / 3;
+
+	vector<GLint> cachePosition(vertexCount, -1);
+	vector<float> vertexScore(vertexCount);
+	for (GLuint v = 0; v < vertexCount; v++)
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	vector<float> triangleScore(triangleCount);
+	vector<bool> added(triangleCount, false);
+	GLint best = 0;
+	for (GLuint t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if (triangleScore[t] > triangleScore[best])
+			best = t;
+	}
+
+	vector<GLuint> output;
+	output.reserve(indices.size());
+	vector<GLuint> cache, newCache;
+	GLuint scanCursor = 0;
+	while (output.size() < indices.size())
+	{
+		// nothing in the cache has triangles left, continue with the next unadded one
+		if (best < 0)
+		{
+			while (added[scanCursor])
+				scanCursor++;
+			best = scanCursor;
+		}
+		added[best] = true;
+		newCache.clear();
+		for (int k = 0; k < 3; k++)
+		{
+			GLuint v = indices[best * 3 + k];
+			output.push_back(v);
+			if (find(newCache.begin(), newCache.end(), v) == newCache.end())
+				newCache.push_back(v);
+			// move the triangle out of the vertex's remaining range
+			GLuint* triangles = &adjacency[adjacencyOffset[v]];
+			for (GLuint i = 0; i < remaining[v]; i++)
+				if (triangles[i] == (GLuint)best)
+				{
+					triangles[i] = triangles[remaining[v] - 1];
+					triangles[remaining[v] - 1] = best;
+					break;
+				}
+			remaining[v]--;
+		}
+		GLuint fresh = newCache.size();
+		for (unsigned int i = 0; i < cache.size(); i++)
+			if (find(newCache.begin(), newCache.begin() + fresh, cache[i]) == newCache.begin() + fresh)
+				newCache.push_back(cache[i]);
+
+		// rescore everything that was or is in the cache, evicted vertices included
+		for (unsigned int i = 0; i < newCache.size(); i++)
+		{
+			GLuint v = newCache[i];
+			cachePosition[v] = i < VERTEX_CACHE_SIZE ? (GLint)i : -1;
+			vertexScore[v] = VertexScore(cachePosition[v], remaining[v]);
+		}
+		best = -1;
+		float bestScore = 0.0f;
+		for (unsigned int i = 0; i < newCache.size(); i++)
+		{
+			GLuint v = newCache[i];
+			for (GLuint a = 0; a < remaining[v]; a++)
+			{
+				GLuint t = adjacency[adjacencyOffset[v] + a];
+				triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if (best < 0 || triangleScore[t] > bestScore)
+				{
+					best = t;
+					bestScore = triangleScore[t];
+				}
+			}
+		}
+		if (newCache.size() > VERTEX_CACHE_SIZE)
+			newCache.resize(VERTEX_CACHE_SIZE);
+		cache.swap(newCache);
+	}
+	indices.swap(output);
+}
+
+void OptimizeOverdraw(vector<GLuint>& indices, const vector<Vertex>& vertices)
+{
+	GLuint triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+	// the same cache the clusters are cut with, a smaller one would misjudge them
+	float targetACMR = MeasureMesh(indices, vertices.size(), VERTEX_CACHE_SIZE).ACMR() * OVERDRAW_CACHE_THRESHOLD;
+
+	// hard boundaries where all three vertices miss, so the cache starts
+	// over, soft ones once the cluster so far is within the target ACMR
+	vector<GLuint> clusterStarts;
+	FifoCache cache(vertices.size(), VERTEX_CACHE_SIZE);
+	GLuint clusterMisses = 0, clusterTriangles = 0;
+	for (GLuint t = 0; t < triangleCount; t++)
+	{
+		GLuint misses = 0;
+		for (int k = 0; k < 3; k++)
+			misses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+		if (t == 0 || misses == 3 || (clusterTriangles > 0 && clusterMisses <= targetACMR * clusterTriangles))
+		{
+			clusterStarts.push_back(t);
+			clusterMisses = 0;
+			clusterTriangles = 0;
+			// soft boundaries cut a run short, so the next cluster starts cold
+			if (misses != 3)
+			{
+				cache.Reset();
+				misses = 0;
+				for (int k = 0; k < 3; k++)
+					misses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+			}
+		}
+		clusterMisses += misses;
+		clusterTriangles++;
+	}
+	clusterStarts.push_back(triangleCount);
+
+	// clusters whose area weighted normal faces away from the mesh centre go first
+	glm::vec3 meshCentroid(0.0f);
+	for (unsigned int i = 0; i < vertices.size(); i++)
+		meshCentroid += vertices[i].Positon;
+	meshCentroid /= (float)vertices.size();
+	GLuint clusterCount = clusterStarts.size() - 1;
+	vector<pair<float, GLuint> > order(clusterCount);
+	for (GLuint c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (GLuint t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			glm::vec3 a = vertices[indices[t * 3]].Positon, b = vertices[indices[t * 3 + 1]].Positon, c2 = vertices[indices[t * 3 + 2]].Positon;
+			glm::vec3 cross = glm::cross(b - a, c2 - a);
+			float triangleArea = glm::length(cross);
+			centroid += (a + b + c2) * (triangleArea / 3.0f);
+			normal += cross;
+			area += triangleArea;
+		}
+		float key = 0.0f;
+		if (area > 0.0f && glm::length(normal) > 0.0f)
+			key = glm::dot(centroid / area - meshCentroid, glm::normalize(normal));
+		order[c] = make_pair(-key, c);
+	}
+	stable_sort(order.begin(), order.end());
+
+	vector<GLuint> output;
+	output.reserve(indices.size());
+	for (GLuint i = 0; i < clusterCount; i++)
+	{
+		GLuint c = order[i].second;
+		output.insert(output.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+	}
+	// the clusters meet the target one by one, their seams may not
+	if (MeasureMesh(output, vertices.size(), VERTEX_CACHE_SIZE).ACMR() <= targetACMR)
+		indices.swap(output);
+}
+
+void OptimizeVertexFetch(vector<Vertex>& vertices, vector<GLuint>& indices)
+{
+	const GLuint UNUSED = 0xFFFFFFFF;
+	vector<GLuint> remap(vertices.size(), UNUSED);
+	vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+	for (unsigned int i = 0; i < indices.size(); i++)
+	{
+		if (remap[indices[i]] == UNUSED)
+		{
+			remap[indices[i]] = ordered.size();
+			ordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = remap[indices[i]];
+	}
+	vertices.swap(ordered);
+}
+
+void OptimizeMesh(vector<Vertex>& vertices, vector<GLuint>& indices, MeshStats& before, MeshStats& after)
+{
+	before = MeasureMesh(indices, vertices.size());
+	WeldVertices(vertices, indices);
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeOverdraw(indices, vertices);
+	OptimizeVertexFetch(vertices, indices);
+	after = MeasureMesh(indices, vertices.size());
+}
+
+void BuildPositionStream(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, vector<glm::vec3>& positions, vector<GLuint>& positionIndices)
+{
+	// with normal and uv cleared WeldVertices compares positions only, + 0.0f turns -0 into 0
+	vector<Vertex> welded(vertexCount);
+	for (GLuint i = 0; i < vertexCount; i++)
+	{
+		welded[i].Positon = vertices[i].Positon + 0.0f;
+		welded[i].Normal = glm::vec3(0.0f);
+		welded[i].TexCoords = glm::vec2(0.0f);
+	}
+	positionIndices.assign(indices, indices + indexCount);
+	WeldVertices(welded, positionIndices);
+	OptimizeVertexCache(positionIndices, welded.size());
+	OptimizeVertexFetch(welded, positionIndices);
+	positions.resize(welded.size());
+	for (unsigned int i = 0; i < welded.size(); i++)
+		positions[i] = welded[i].Positon;
+}
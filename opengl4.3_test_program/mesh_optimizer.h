@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+#include "mesh.h"
+
+using namespace std;
+
+// entries the triangle order is optimized for, and the conservative FIFO
+// the statistics are measured with
+const GLuint VERTEX_CACHE_SIZE = 32, VERTEX_CACHE_STATS_SIZE = 16;
+// ACMR the overdraw pass may give up for better triangle order, relative
+const float OVERDRAW_CACHE_THRESHOLD = 1.05f;
+
+// post-transform cache behaviour of an index list; these add up over meshes
+struct MeshStats
+{
+	GLuint triangles;
+	// distinct vertices referenced and vertices the cache transforms
+	GLuint vertices, transformed;
+	// average cache miss ratio, transformed per triangle, 0.5 at best
+	float ACMR() const;
+	// average transform to vertex ratio, transformed per vertex, 1.0 at best
+	float ATVR() const;
+};
+
+MeshStats MeasureMesh(const vector<GLuint>& indices, GLuint vertexCount, GLuint cacheSize = VERTEX_CACHE_STATS_SIZE);
+
+// merges vertices whose position, normal and uv are identical, returns how many went
+GLuint WeldVertices(vector<Vertex>& vertices, vector<GLuint>& indices);
+
+// Reorders triangles for post-transform cache reuse with Forsyth's linear
+// speed algorithm: the next triangle is the one whose vertices score
+// highest, favouring vertices recently in the cache and vertices with few
+// triangles left, so no vertex is left behind to be transformed again.
+void OptimizeVertexCache(vector<GLuint>& indices, GLuint vertexCount);
+
+// Splits a cache optimized order into clusters wherever the cache would
+// start over anyway, or ACMR stays within OVERDRAW_CACHE_THRESHOLD, and
+// puts outward facing clusters first so they tend to occlude the rest
+// from any viewpoint. ACMR is measured with the VERTEX_CACHE_SIZE cache
+// throughout, and an order that ends up over the threshold is dropped.
+void OptimizeOverdraw(vector<GLuint>& indices, const vector<Vertex>& vertices);
+
+// renumbers vertices in the order the triangles first use them, so
+// fetches walk the vertex buffer forward; unreferenced vertices are dropped
+void OptimizeVertexFetch(vector<Vertex>& vertices, vector<GLuint>& indices);
+
+// weld, cache, overdraw and fetch in that order, measuring before and after
+void OptimizeMesh(vector<Vertex>& vertices, vector<GLuint>& indices, MeshStats& before, MeshStats& after);
+
+// The same triangles for depth only passes: vertices split only by normal
+// or uv are welded by position, and the result is cache and fetch optimized
+// on its own, so depth passes transform fewer and smaller vertices.
+void BuildPositionStream(const Vertex* vertices, GLuint vertexCount, const GLuint* indices, GLuint indexCount, vector<glm::vec3>& positions, vector<GLuint>& positionIndices);
@@ -1,20 +1,34 @@
 #include "model.h"
+#include "gl_state.h"
+#include "material_table.h"
+#include "geometry_heap.h"
+#include <assimp/config.h>
 
-Model::Model(char* path)
+Model::Model(char* path, GeometryHeap& heap, MaterialTable* materials)
 {
+	this->heap = &heap;
+	this->materials = materials;
 	loadModel(path);
 }
 
-void Model::Draw(Shader shader)
+void Model::Draw(Shader& shader)
 {
 	for (unsigned int i = 0; i < meshes.size(); i++)
 		meshes[i].Draw(shader);
 }
 
+void Model::DrawDepth(Shader& shader)
+{
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].DrawDepth(shader);
+}
+
 void Model::loadModel(string path)
 {
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+	// every mesh has to fit a heap range with 16 bit indices
+	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, GEOMETRY_RANGE_MAX_VERTICES);
+	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_SplitLargeMeshes);
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		cout << "ERROR::ASSIMP::" << importer.GetErrorString() << endl;
@@ -22,7 +36,11 @@ void Model::loadModel(string path)
 	}
 	directory = path.substr(0, path.find_last_of('/'));
 
+	MeshStats none = { 0, 0, 0 };
+	imported = optimized = none;
 	processNode(scene->mRootNode, scene);
+	cout << "model " << path << ": " << imported.vertices << " -> " << optimized.vertices << " vertices, ACMR "
+		<< imported.ACMR() << " -> " << optimized.ACMR() << ", ATVR " << imported.ATVR() << " -> " << optimized.ATVR() << endl;
 }
 
 void Model::processNode(aiNode* node, const aiScene* scene)
@@ -76,6 +94,15 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 			indices.push_back(mesh->mFaces[i].mIndices[j]);
 		}
 	}
+	// assimp leaves vertices unwelded and triangles in file order
+	MeshStats before, after;
+	OptimizeMesh(vertices, indices, before, after);
+	imported.triangles += before.triangles;
+	imported.vertices += before.vertices;
+	imported.transformed += before.transformed;
+	optimized.triangles += after.triangles;
+	optimized.vertices += after.vertices;
+	optimized.transformed += after.transformed;
 	//cout << "----material Number: " << mesh->mMaterialIndex + 1 << endl;
 	if (mesh->mMaterialIndex >= 0)
 	{
@@ -87,7 +114,10 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 	}
 
-	return Mesh(vertices, indices, textures);
+	Mesh result(vertices, indices, textures, *heap);
+	if (materials && !textures.empty() && textures[0].type == "texture_diffuse")
+		result.material = materials->Add(textures[0].id);
+	return result;
 }
 
 vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
@@ -141,7 +171,7 @@ GLuint Model::TextureFromFile(string directory, const char* path)
 		else if (img_channels == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLState::BindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, img_width, img_height, 0, format, GL_UNSIGNED_BYTE, image);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
@@ -1,16 +1,23 @@
 #pragma once
 #include "mesh.h"
+#include "mesh_optimizer.h"
 #include "stb_image.h"
 
 class Model
 {
 public:
-	Model(char *path);
-	void Draw(Shader shader);
+	// with a material table the meshes draw through bindless handles
+	Model(char *path, GeometryHeap& heap, MaterialTable* materials = NULL);
+	void Draw(Shader& shader);
+	void DrawDepth(Shader& shader);
 	vector<Mesh> meshes;
 	vector<Texture> texture_loaded;
+	// cache behaviour of all meshes as imported and after OptimizeMesh
+	MeshStats imported, optimized;
 private:
 	string directory;
+	GeometryHeap* heap;
+	MaterialTable* materials;
 	void loadModel(string path);
 	void processNode(aiNode* node, const aiScene* scene);
 	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
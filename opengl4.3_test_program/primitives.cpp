@@ -0,0 +1,197 @@
+#include "primitives.h"
+#include "mesh_optimizer.h"
+#include <iostream>
+#include <cmath>
+
+const char* PRIMITIVE_NAMES[PRIMITIVE_COUNT] = { "cube", "sphere", "plane", "cylinder", "cone" };
+const GLfloat PRIMITIVE_PI = 3.14159265358979f;
+
+static void AddVertex(PrimitiveMesh& mesh, glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+{
+	Vertex vertex;
+	vertex.Positon = position;
+	vertex.Normal = normal;
+	vertex.TexCoords = uv;
+	mesh.vertices.push_back(vertex);
+}
+
+static void AddTriangle(PrimitiveMesh& mesh, GLuint a, GLuint b, GLuint c)
+{
+	mesh.indices.push_back(a);
+	mesh.indices.push_back(b);
+	mesh.indices.push_back(c);
+}
+
+// four vertices per face, u x v is the face normal
+static void MakeCube(PrimitiveMesh& mesh)
+{
+	const glm::vec3 normals[6] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+	const glm::vec3 us[6] = { glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0) };
+	const glm::vec3 vs[6] = { glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, -1), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0) };
+	const glm::vec2 corners[4] = { glm::vec2(0, 0), glm::vec2(1, 0), glm::vec2(1, 1), glm::vec2(0, 1) };
+	for (int face = 0; face < 6; face++)
+	{
+		GLuint first = mesh.vertices.size();
+		for (int c = 0; c < 4; c++)
+			AddVertex(mesh, normals[face] * 0.5f + us[face] * (corners[c].x - 0.5f) + vs[face] * (corners[c].y - 0.5f), normals[face], corners[c]);
+		AddTriangle(mesh, first, first + 1, first + 2);
+		AddTriangle(mesh, first, first + 2, first + 3);
+	}
+}
+
+// rings from the top pole down, the pole rows only make one triangle per segment
+static void MakeSphere(PrimitiveMesh& mesh, GLuint segments, GLuint rings)
+{
+	for (GLuint r = 0; r <= rings; r++)
+		for (GLuint s = 0; s <= segments; s++)
+		{
+			// the seam and the poles repeat their positions exactly, so welding closes the mesh
+			GLfloat theta = PRIMITIVE_PI * r / rings;
+			GLfloat phi = 2.0f * PRIMITIVE_PI * (s % segments) / segments;
+			GLfloat ring = r == 0 || r == rings ? 0.0f : sin(theta);
+			glm::vec3 normal(ring * cos(phi), cos(theta), ring * sin(phi));
+			AddVertex(mesh, normal * 0.5f, normal, glm::vec2((GLfloat)s / segments, 1.0f - (GLfloat)r / rings));
+		}
+	GLuint row = segments + 1;
+	for (GLuint r = 0; r < rings; r++)
+		for (GLuint s = 0; s < segments; s++)
+		{
+			GLuint a = r * row + s, b = a + row, c = b + 1, d = a + 1;
+			if (r != rings - 1)
+				AddTriangle(mesh, a, c, b);
+			if (r != 0)
+				AddTriangle(mesh, a, d, c);
+		}
+}
+
+// a grid in the xz plane facing +y
+static void MakePlane(PrimitiveMesh& mesh)
+{
+	GLuint n = PRIMITIVE_PLANE_DIVISIONS;
+	for (GLuint i = 0; i <= n; i++)
+		for (GLuint j = 0; j <= n; j++)
+		{
+			glm::vec2 uv((GLfloat)i / n, (GLfloat)j / n);
+			AddVertex(mesh, glm::vec3(uv.x - 0.5f, 0.0f, uv.y - 0.5f), glm::vec3(0.0f, 1.0f, 0.0f), uv);
+		}
+	for (GLuint i = 0; i < n; i++)
+		for (GLuint j = 0; j < n; j++)
+		{
+			GLuint a = i * (n + 1) + j;
+			AddTriangle(mesh, a, a + 1, a + n + 2);
+			AddTriangle(mesh, a, a + n + 2, a + n + 1);
+		}
+}
+
+// a flat disc of radius 0.5 at height y, facing up or down
+static void AddCap(PrimitiveMesh& mesh, GLfloat y, bool up)
+{
+	glm::vec3 normal(0.0f, up ? 1.0f : -1.0f, 0.0f);
+	GLuint center = mesh.vertices.size();
+	AddVertex(mesh, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f));
+	for (GLuint s = 0; s <= PRIMITIVE_SEGMENTS; s++)
+	{
+		GLfloat phi = 2.0f * PRIMITIVE_PI * s / PRIMITIVE_SEGMENTS;
+		AddVertex(mesh, glm::vec3(0.5f * cos(phi), y, 0.5f * sin(phi)), normal, glm::vec2(0.5f + 0.5f * cos(phi), 0.5f + 0.5f * sin(phi)));
+	}
+	for (GLuint s = 0; s < PRIMITIVE_SEGMENTS; s++)
+	{
+		if (up)
+			AddTriangle(mesh, center, center + s + 2, center + s + 1);
+		else
+			AddTriangle(mesh, center, center + s + 1, center + s + 2);
+	}
+}
+
+static void MakeCylinder(PrimitiveMesh& mesh)
+{
+	for (GLuint s = 0; s <= PRIMITIVE_SEGMENTS; s++)
+	{
+		GLfloat phi = 2.0f * PRIMITIVE_PI * s / PRIMITIVE_SEGMENTS;
+		glm::vec3 normal(cos(phi), 0.0f, sin(phi));
+		GLfloat u = (GLfloat)s / PRIMITIVE_SEGMENTS;
+		AddVertex(mesh, normal * 0.5f - glm::vec3(0.0f, 0.5f, 0.0f), normal, glm::vec2(u, 0.0f));
+		AddVertex(mesh, normal * 0.5f + glm::vec3(0.0f, 0.5f, 0.0f), normal, glm::vec2(u, 1.0f));
+	}
+	for (GLuint s = 0; s < PRIMITIVE_SEGMENTS; s++)
+	{
+		GLuint bottom = s * 2, top = bottom + 1;
+		AddTriangle(mesh, bottom, top, top + 2);
+		AddTriangle(mesh, bottom, top + 2, bottom + 2);
+	}
+	AddCap(mesh, 0.5f, true);
+	AddCap(mesh, -0.5f, false);
+}
+
+// the apex is split per segment so every side triangle gets its own normal there
+static void MakeCone(PrimitiveMesh& mesh)
+{
+	for (GLuint s = 0; s <= PRIMITIVE_SEGMENTS; s++)
+	{
+		GLfloat phi = 2.0f * PRIMITIVE_PI * s / PRIMITIVE_SEGMENTS;
+		GLfloat apexPhi = 2.0f * PRIMITIVE_PI * (s + 0.5f) / PRIMITIVE_SEGMENTS;
+		GLfloat u = (GLfloat)s / PRIMITIVE_SEGMENTS;
+		AddVertex(mesh, glm::vec3(0.5f * cos(phi), -0.5f, 0.5f * sin(phi)), glm::normalize(glm::vec3(cos(phi), 0.5f, sin(phi))), glm::vec2(u, 0.0f));
+		AddVertex(mesh, glm::vec3(0.0f, 0.5f, 0.0f), glm::normalize(glm::vec3(cos(apexPhi), 0.5f, sin(apexPhi))), glm::vec2(u + 0.5f / PRIMITIVE_SEGMENTS, 1.0f));
+	}
+	for (GLuint s = 0; s < PRIMITIVE_SEGMENTS; s++)
+		AddTriangle(mesh, s * 2, s * 2 + 1, s * 2 + 2);
+	AddCap(mesh, -0.5f, false);
+}
+
+static void ComputeRadius(PrimitiveMesh& mesh)
+{
+	mesh.radius = 0.0f;
+	for (unsigned int i = 0; i < mesh.vertices.size(); i++)
+		mesh.radius = glm::max(mesh.radius, glm::length(mesh.vertices[i].Positon));
+}
+
+PrimitiveMesh MakePrimitive(PrimitiveType type)
+{
+	PrimitiveMesh mesh;
+	switch (type)
+	{
+	case PRIMITIVE_CUBE:
+		MakeCube(mesh);
+		break;
+	case PRIMITIVE_SPHERE:
+		MakeSphere(mesh, PRIMITIVE_SEGMENTS, PRIMITIVE_RINGS);
+		break;
+	case PRIMITIVE_PLANE:
+		MakePlane(mesh);
+		break;
+	case PRIMITIVE_CYLINDER:
+		MakeCylinder(mesh);
+		break;
+	default:
+		MakeCone(mesh);
+		break;
+	}
+	ComputeRadius(mesh);
+	return mesh;
+}
+
+PrimitiveMesh MakeSphere(GLuint segments, GLuint rings)
+{
+	PrimitiveMesh mesh;
+	MakeSphere(mesh, segments, rings);
+	ComputeRadius(mesh);
+	return mesh;
+}
+
+PrimitiveLibrary::PrimitiveLibrary(GeometryHeap& heap)
+{
+	for (int type = 0; type < PRIMITIVE_COUNT; type++)
+	{
+		PrimitiveMesh& mesh = meshes[type];
+		mesh = MakePrimitive((PrimitiveType)type);
+		MeshStats generated, optimized;
+		OptimizeMesh(mesh.vertices, mesh.indices, generated, optimized);
+		ranges[type] = heap.Allocate(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+		// unindexed, every triangle transformed three vertices
+		cout << "primitive " << PRIMITIVE_NAMES[type] << ": " << optimized.triangles << " triangles, "
+			<< optimized.transformed << " vertices transformed instead of " << optimized.triangles * 3
+			<< ", ACMR " << generated.ACMR() << " -> " << optimized.ACMR()
+			<< ", " << ranges[type].positionCount << " positions for depth" << endl;
+	}
+}
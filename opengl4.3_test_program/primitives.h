@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "mesh.h"
+#include "geometry_heap.h"
+
+using namespace std;
+
+enum PrimitiveType
+{
+	PRIMITIVE_CUBE,
+	PRIMITIVE_SPHERE,
+	PRIMITIVE_PLANE,
+	PRIMITIVE_CYLINDER,
+	PRIMITIVE_CONE,
+	PRIMITIVE_COUNT
+};
+
+// tessellation of the round primitives
+const GLuint PRIMITIVE_SEGMENTS = 16, PRIMITIVE_RINGS = 8, PRIMITIVE_PLANE_DIVISIONS = 8;
+
+// An indexed mesh inside the unit cube around the origin, wound counter
+// clockwise seen from outside. Vertices are shared wherever position,
+// normal and uv agree, so the cube has 24 instead of 36.
+struct PrimitiveMesh
+{
+	vector<Vertex> vertices;
+	vector<GLuint> indices;
+	// bounding sphere around the origin
+	GLfloat radius;
+};
+
+// generated in plain order, OptimizeMesh reorders it
+PrimitiveMesh MakePrimitive(PrimitiveType type);
+// the sphere primitive at any tessellation
+PrimitiveMesh MakeSphere(GLuint segments, GLuint rings);
+
+// Every primitive generated once, cache optimized and placed in the
+// geometry heap, so instances of any primitive are a range of the same
+// buffers. The CPU copies serve shadow casters, baking and batching.
+class PrimitiveLibrary
+{
+public:
+	PrimitiveLibrary(GeometryHeap& heap);
+	PrimitiveMesh meshes[PRIMITIVE_COUNT];
+	GeometryRange ranges[PRIMITIVE_COUNT];
+};
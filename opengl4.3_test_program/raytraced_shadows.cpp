@@ -0,0 +1,74 @@
+#include "raytraced_shadows.h"
+#include "gl_state.h"
+#include <iostream>
+
+RayTracedShadows::RayTracedShadows(const vector<glm::vec4>& trianglePositions, GLuint width, GLuint height)
+	: traceShader("shaders/raytraced_shadows.comp")
+{
+	this->width = width;
+	this->height = height;
+
+	BVH bvh(trianglePositions);
+	glGenBuffers(1, &nodeBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, nodeBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, bvh.nodes.size() * sizeof(BVHNode), &bvh.nodes[0], GL_STATIC_DRAW);
+	glGenBuffers(1, &triangleBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, triangleBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, bvh.triangles.size() * sizeof(glm::vec4), &bvh.triangles[0], GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glGenTextures(1, &sceneDepth);
+	GLState::BindTexture(GL_TEXTURE_2D, sceneDepth);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &shadowMask);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, shadowMask);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8, width, height, MAX_RAYTRACED_LIGHTS);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenFramebuffers(1, &depthFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, sceneDepth, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Framebuffer not complete!" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	traceShader.Use();
+	traceShader.SetInt("sceneDepth", 0);
+}
+
+void RayTracedShadows::BeginDepthPrepass(GLint x, GLint y, GLsizei viewWidth, GLsizei viewHeight)
+{
+	glViewport(x, y, viewWidth, viewHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void RayTracedShadows::Trace(const glm::mat4& projection, const glm::mat4& view, const vector<glm::vec4>& lights, GLint x, GLint y, GLsizei viewWidth, GLsizei viewHeight)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	GLuint lightCount = glm::min((GLuint)lights.size(), MAX_RAYTRACED_LIGHTS);
+	glm::mat4 invViewProjection = glm::inverse(projection * view);
+
+	traceShader.Use();
+	traceShader.SetMat4("invViewProjection", invViewProjection);
+	traceShader.SetVec4Array("lights", &lights[0], lightCount);
+	traceShader.SetUint("lightCount", lightCount);
+	traceShader.SetIVec2("viewOffset", glm::ivec2(x, y));
+	traceShader.SetIVec2("viewSize", glm::ivec2(viewWidth, viewHeight));
+
+	GLState::ActiveTexture(GL_TEXTURE0);
+	GLState::BindTexture(GL_TEXTURE_2D, sceneDepth);
+	glBindImageTexture(1, shadowMask, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R8);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, nodeBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, triangleBuffer);
+	glDispatchCompute((viewWidth + 7) / 8, (viewHeight + 7) / 8, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
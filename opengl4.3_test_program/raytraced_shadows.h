@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "bvh.h"
+
+using namespace std;
+
+const GLuint MAX_RAYTRACED_LIGHTS = 4;
+
+// Point light shadows without depth maps: a compute pass traces one shadow ray
+// per visible pixel through a BVH of the scene and writes a per light shadow mask.
+class RayTracedShadows
+{
+public:
+	RayTracedShadows(const vector<glm::vec4>& trianglePositions, GLuint width, GLuint height);
+	void BeginDepthPrepass(GLint x, GLint y, GLsizei viewWidth, GLsizei viewHeight);
+	void Trace(const glm::mat4& projection, const glm::mat4& view, const vector<glm::vec4>& lights, GLint x, GLint y, GLsizei viewWidth, GLsizei viewHeight);
+	GLuint shadowMask;
+private:
+	Shader traceShader;
+	GLuint nodeBuffer, triangleBuffer;
+	GLuint depthFBO, sceneDepth;
+	GLuint width, height;
+};
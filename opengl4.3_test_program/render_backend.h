@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+using namespace std;
+
+// Resources are referred to by handles owned by the backend. The GL backend
+// hands out GL object names, so GL only code can keep using them directly.
+typedef uint32_t RenderHandle;
+const RenderHandle NULL_RENDER_HANDLE = 0;
+
+enum BufferUsage
+{
+	BUFFER_VERTEX,
+	BUFFER_INDEX,
+	BUFFER_UNIFORM,
+	BUFFER_STORAGE,
+	BUFFER_INSTANCE
+};
+
+// one instanced draw of an indexed range of the shared geometry
+struct BackendDraw
+{
+	uint32_t indexCount, firstIndex, baseVertex;
+	uint32_t instanceCount, firstInstance;
+	bool twoSided;
+};
+
+// a point light's depth cube, rendered as distance to the light over far
+struct DepthCubePass
+{
+	RenderHandle target;
+	glm::mat4 faceMatrices[6];
+	glm::vec3 lightPos;
+	float farPlane;
+	// bit i renders face GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+	uint32_t faceMask;
+};
+
+// The operations the renderer needs from a graphics API: buffers, textures,
+// depth cube targets and the depth cube pass with its draws. Geometry is
+// always pulled from a vertex storage buffer by index with per instance
+// transforms laid out as InstanceData, see instance_culling.h.
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+	virtual const char* Name() const = 0;
+	virtual RenderHandle CreateBuffer(BufferUsage usage, size_t size, const void* data) = 0;
+	virtual void UpdateBuffer(RenderHandle buffer, size_t offset, size_t size, const void* data) = 0;
+	// rgba8, repeating
+	virtual RenderHandle CreateTexture(int width, int height, const unsigned char* rgba) = 0;
+	virtual RenderHandle CreateDepthCube(int size) = 0;
+	// the PackedPosition storage buffer with its QuantizationBounds table, the
+	// GeometryIndex buffer and the instance buffer draws refer to; draws use
+	// the position stream's ranges, see DepthGeometry
+	virtual void SetGeometry(RenderHandle positions, RenderHandle bounds, RenderHandle indices, RenderHandle instances) = 0;
+	// faceDraws holds the draws of each of the six faces
+	virtual void RenderDepthCube(const DepthCubePass& pass, const vector<BackendDraw> faceDraws[6]) = 0;
+	// reads one rendered face back, size * size depths; waits for the GPU so
+	// it is only meant for tests
+	virtual void ReadDepthFace(RenderHandle cube, int face, vector<float>& depths) = 0;
+};
+
+class CommandListBuilder;
+
+// returns NULL when the Vulkan backend is not compiled in or no device is
+// found, command buffers are recorded on the workers' threads
+RenderBackend* CreateVulkanBackend(CommandListBuilder* workers);
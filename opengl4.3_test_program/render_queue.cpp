@@ -0,0 +1,127 @@
+#include "render_queue.h"
+#include <cstring>
+#include "gl_state.h"
+
+GLuint RenderQueue::draws = 0;
+GLuint RenderQueue::programChanges = 0;
+GLuint RenderQueue::textureChanges = 0;
+GLuint RenderQueue::VAOChanges = 0;
+
+uint64_t RenderQueue::MakeKey(GLuint pass, GLuint program, GLuint texture, GLuint VAO, GLfloat depth, GLfloat far)
+{
+	const uint64_t depthLevels = (1 << 26) - 1;
+	GLfloat normalized = depth / far;
+	if (normalized < 0.0f)
+		normalized = 0.0f;
+	if (normalized > 1.0f)
+		normalized = 1.0f;
+	uint64_t key = (uint64_t)(pass & 0xF) << 60;
+	key |= (uint64_t)(program & 0x3FF) << 50;
+	key |= (uint64_t)(texture & 0xFFF) << 38;
+	key |= (uint64_t)(VAO & 0xFFF) << 26;
+	key |= (uint64_t)(normalized * depthLevels);
+	return key;
+}
+
+void RenderQueue::Push(const RenderItem& item)
+{
+	items.push_back(item);
+}
+
+// LSD radix sort of item indices, 8 bits per pass, stable so equal keys keep push order
+void RenderQueue::Sort()
+{
+	uint32_t count = items.size();
+	order.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+		order[i] = i;
+
+	if (count < RADIX_SORT_THRESHOLD)
+	{
+		// ties broken by index so the result matches the radix sort
+		const vector<RenderItem>& sortItems = items;
+		sort(order.begin(), order.end(), [&sortItems](uint32_t a, uint32_t b)
+		{
+			return sortItems[a].key < sortItems[b].key || (sortItems[a].key == sortItems[b].key && a < b);
+		});
+		return;
+	}
+
+	// every byte's histogram in a single pass over the keys
+	memset(histograms, 0, sizeof(histograms));
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t key = items[i].key;
+		for (int byte = 0; byte < 8; byte++)
+			histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+	}
+
+	scratch.resize(count);
+	for (int byte = 0; byte < 8; byte++)
+	{
+		uint32_t* counts = histograms[byte];
+		int shift = byte * 8;
+		// a byte every key shares would only copy the order
+		if (counts[(items[0].key >> shift) & 0xFF] == count)
+			continue;
+		uint32_t sum = 0;
+		for (uint32_t digit = 0; digit < 256; digit++)
+		{
+			uint32_t digitCount = counts[digit];
+			counts[digit] = sum;
+			sum += digitCount;
+		}
+		for (uint32_t i = 0; i < count; i++)
+			scratch[counts[(items[order[i]].key >> shift) & 0xFF]++] = order[i];
+		order.swap(scratch);
+	}
+}
+
+void RenderQueue::Submit()
+{
+	Shader* shader = NULL;
+	GLuint texture = 0, VAO = 0;
+	bool twoSided = false;
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		const RenderItem& item = items[order[i]];
+		if (item.shader != shader)
+		{
+			shader = item.shader;
+			shader->Use();
+			programChanges++;
+		}
+		if (item.texture != 0 && item.texture != texture)
+		{
+			texture = item.texture;
+			GLState::ActiveTexture(GL_TEXTURE0);
+			GLState::BindTexture(GL_TEXTURE_2D, texture);
+			textureChanges++;
+		}
+		if (item.VAO != VAO)
+		{
+			VAO = item.VAO;
+			GLState::BindVertexArray(VAO);
+			VAOChanges++;
+		}
+		if (item.twoSided != twoSided)
+		{
+			twoSided = item.twoSided;
+			if (twoSided)
+				GLState::Disable(GL_CULL_FACE);
+			else
+				GLState::Enable(GL_CULL_FACE);
+		}
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, item.geometry.indexCount, GEOMETRY_INDEX_TYPE, (void*)(item.geometry.firstIndex * sizeof(GeometryIndex)),
+			item.instanceCount, item.geometry.firstVertex, item.firstInstance);
+		draws++;
+	}
+	if (twoSided)
+		GLState::Enable(GL_CULL_FACE);
+}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	order.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <GL/glew.h>
+#include "shader.h"
+#include "geometry_heap.h"
+
+using namespace std;
+
+// One instanced draw with everything submission needs to set up for it
+struct RenderItem
+{
+	uint64_t key;
+	Shader* shader;
+	GLuint texture;
+	GLuint VAO;
+	// indexed range of the geometry heap, whose index buffer the VAO binds
+	GeometryRange geometry;
+	GLuint firstInstance, instanceCount;
+	// the room is seen from inside, it is drawn two sided with a
+	// REVERSE_NORMALS shader variant
+	bool twoSided;
+};
+
+// below this many items a comparison sort beats the radix passes
+const uint32_t RADIX_SORT_THRESHOLD = 256;
+
+// Draws are collected, radix sorted by a 64-bit key and then submitted,
+// so program, texture and VAO changes only happen between key ranges and
+// opaque draws reach the depth test front to back.
+//   pass:4 | program:10 | texture:12 | VAO:12 | depth:26
+class RenderQueue
+{
+public:
+	static uint64_t MakeKey(GLuint pass, GLuint program, GLuint texture, GLuint VAO, GLfloat depth, GLfloat far);
+	void Push(const RenderItem& item);
+	void Sort();
+	void Submit();
+	void Clear();
+	// the sorted items, valid after Sort
+	GLuint Size() const { return order.size(); }
+	const RenderItem& Sorted(GLuint i) const { return items[order[i]]; }
+	// accumulated over every Submit of every queue, reset by whoever reports them
+	static GLuint draws, programChanges, textureChanges, VAOChanges;
+private:
+	vector<RenderItem> items;
+	vector<uint32_t> order, scratch;
+	// one 8-bit digit histogram per key byte, kept so sorting never allocates
+	uint32_t histograms[8][256];
+};
@@ -1,6 +1,58 @@
 #include "shader.h"
+#include "gl_state.h"
 
-Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
+GLuint Shader::uniformUploads = 0;
+GLuint Shader::elidedUploads = 0;
+
+// includes nested deeper than this are taken for a cycle
+const int MAX_INCLUDE_DEPTH = 8;
+
+// replaces every #include "file" line with the file, found next to the shader that includes it
+static void ResolveIncludes(std::string& code, const std::string& path, int depth = 0)
+{
+	std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+	size_t position = 0;
+	while ((position = code.find("#include", position)) != std::string::npos)
+	{
+		size_t lineEnd = code.find('\n', position);
+		if (lineEnd == std::string::npos)
+			lineEnd = code.size();
+		size_t open = code.find('"', position);
+		size_t close = open == std::string::npos ? open : code.find('"', open + 1);
+		std::string included;
+		if (close == std::string::npos || close > lineEnd)
+			std::cout << "ERROR::SHADER::INCLUDE_MALFORMED " << path << std::endl;
+		else if (depth >= MAX_INCLUDE_DEPTH)
+			std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP " << path << std::endl;
+		else
+		{
+			std::string includePath = directory + code.substr(open + 1, close - open - 1);
+			std::ifstream includeFile(includePath.c_str());
+			if (includeFile)
+			{
+				std::stringstream includeStream;
+				includeStream << includeFile.rdbuf();
+				included = includeStream.str();
+				ResolveIncludes(included, includePath, depth + 1);
+			}
+			else
+				std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << includePath << std::endl;
+		}
+		code.replace(position, lineEnd - position, included);
+		position += included.size();
+	}
+}
+
+static void InjectDefines(std::string& code, const std::vector<std::string>& defines)
+{
+	std::string block;
+	for (size_t i = 0; i < defines.size(); i++)
+		block += "#define " + defines[i] + "\n";
+	size_t lineEnd = code.find('\n');
+	code.insert(lineEnd == std::string::npos ? code.size() : lineEnd + 1, block);
+}
+
+Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::vector<std::string>& defines)
 {
 	std::string vertexCode;
 	std::string fragmentCode;
@@ -27,6 +79,10 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
+	ResolveIncludes(vertexCode, vertexPath);
+	ResolveIncludes(fragmentCode, fragmentPath);
+	InjectDefines(vertexCode, defines);
+	InjectDefines(fragmentCode, defines);
 
 	const GLchar* vShaderCode = vertexCode.c_str();
 	const GLchar* fShaderCode = fragmentCode.c_str();
@@ -68,6 +124,8 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+
+	ReflectUniforms();
 }
 
 Shader::Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath)
@@ -104,6 +162,9 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLcha
 	{
 		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 	}
+	ResolveIncludes(vertexCode, vertexPath);
+	ResolveIncludes(geometryCode, geometryPath);
+	ResolveIncludes(fragmentCode, fragmentPath);
 
 	const GLchar* vShaderCode = vertexCode.c_str();
 	const GLchar* gShaderCode = geometryCode.c_str();
@@ -158,11 +219,190 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLcha
 	glDeleteShader(vertex);
 	glDeleteShader(geometry);
 	glDeleteShader(fragment);
+
+	ReflectUniforms();
 }
 
+Shader::Shader(const GLchar* computePath)
+{
+	std::string computeCode;
+	std::ifstream cShaderFile;
+
+	cShaderFile.exceptions(std::ifstream::badbit);
+	try
+	{
+		cShaderFile.open(computePath);
+		std::stringstream cShaderStream;
+		cShaderStream << cShaderFile.rdbuf();
+
+		cShaderFile.close();
+
+		computeCode = cShaderStream.str();
+	}
+	catch (const std::ifstream::failure&)
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+	}
+	ResolveIncludes(computeCode, computePath);
+
+	const GLchar* cShaderCode = computeCode.c_str();
+
+	GLuint compute;
+	GLint success;
+	GLchar infoLog[512];
+
+	compute = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(compute, 1, &cShaderCode, NULL);
+	glCompileShader(compute);
+	glGetShaderiv(compute, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(compute, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+	};
+
+	this->Program = glCreateProgram();
+	glAttachShader(this->Program, compute);
+	glLinkProgram(this->Program);
+	glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	}
+
+	glDeleteShader(compute);
+
+	ReflectUniforms();
+}
 
 
 void Shader::Use()
 {
-	glUseProgram(this->Program);
+	GLState::UseProgram(this->Program);
+}
+
+void Shader::ReflectUniforms()
+{
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(this->Program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(this->Program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> buffer(maxLength + 1);
+	for (GLint i = 0; i < count; i++)
+	{
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(this->Program, i, (GLsizei)buffer.size(), NULL, &size, &type, buffer.data());
+		std::string name(buffer.data());
+		GLint location = glGetUniformLocation(this->Program, name.c_str());
+		// uniforms inside blocks have no location
+		if (location < 0)
+			continue;
+		// arrays are reported as "name[0]", register the bare name and every element
+		size_t bracket = name.find('[');
+		if (bracket != std::string::npos)
+		{
+			std::string base = name.substr(0, bracket);
+			uniformLocations[base] = location;
+			for (GLint element = 0; element < size; element++)
+			{
+				std::string elementName = base + "[" + std::to_string(element) + "]";
+				uniformLocations[elementName] = glGetUniformLocation(this->Program, elementName.c_str());
+			}
+		}
+		else
+			uniformLocations[name] = location;
+	}
+}
+
+GLint Shader::GetUniformLocation(const std::string& name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator it = uniformLocations.find(name);
+	return it != uniformLocations.end() ? it->second : -1;
+}
+
+bool Shader::UniformChanged(GLint location, const void* data, size_t size)
+{
+	if (location < 0)
+		return false;
+	std::vector<unsigned char>& cached = uniformValues[location];
+	if (cached.size() == size && std::memcmp(cached.data(), data, size) == 0)
+	{
+		elidedUploads++;
+		return false;
+	}
+	cached.assign((const unsigned char*)data, (const unsigned char*)data + size);
+	uniformUploads++;
+	return true;
+}
+
+// glProgramUniform so the setters do not depend on which program is bound
+void Shader::SetInt(const std::string& name, GLint value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value, sizeof(value)))
+		glProgramUniform1i(this->Program, location, value);
+}
+
+void Shader::SetUint(const std::string& name, GLuint value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value, sizeof(value)))
+		glProgramUniform1ui(this->Program, location, value);
+}
+
+void Shader::SetFloat(const std::string& name, GLfloat value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value, sizeof(value)))
+		glProgramUniform1f(this->Program, location, value);
+}
+
+void Shader::SetVec2(const std::string& name, const glm::vec2& value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value[0], sizeof(value)))
+		glProgramUniform2fv(this->Program, location, 1, &value[0]);
+}
+
+void Shader::SetIVec2(const std::string& name, const glm::ivec2& value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value[0], sizeof(value)))
+		glProgramUniform2iv(this->Program, location, 1, &value[0]);
+}
+
+void Shader::SetVec3(const std::string& name, const glm::vec3& value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value[0], sizeof(value)))
+		glProgramUniform3fv(this->Program, location, 1, &value[0]);
+}
+
+void Shader::SetVec4(const std::string& name, const glm::vec4& value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value[0], sizeof(value)))
+		glProgramUniform4fv(this->Program, location, 1, &value[0]);
+}
+
+void Shader::SetMat4(const std::string& name, const glm::mat4& value)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &value[0][0], sizeof(value)))
+		glProgramUniformMatrix4fv(this->Program, location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::SetVec4Array(const std::string& name, const glm::vec4* values, GLsizei count)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &values[0][0], sizeof(glm::vec4) * count))
+		glProgramUniform4fv(this->Program, location, count, &values[0][0]);
+}
+
+void Shader::SetMat4Array(const std::string& name, const glm::mat4* values, GLsizei count)
+{
+	GLint location = GetUniformLocation(name);
+	if (UniformChanged(location, &values[0][0][0], sizeof(glm::mat4) * count))
+		glProgramUniformMatrix4fv(this->Program, location, count, GL_FALSE, &values[0][0][0]);
 }
@@ -4,14 +4,43 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 
 class Shader
 {
 public:
 	GLuint Program;
-	Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
+	// #include "file" lines are replaced by the file, relative to the including shader;
+	// defines are injected after #version, for compile-time shader variants
+	Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const std::vector<std::string>& defines = std::vector<std::string>());
 	Shader(const GLchar* vertexPath, const GLchar* geometryPath, const GLchar* fragmentPath);
+	Shader(const GLchar* computePath);
 	void Use();
+
+	// Typed setters, uploads whose value did not change are skipped
+	GLint GetUniformLocation(const std::string& name) const;
+	void SetInt(const std::string& name, GLint value);
+	void SetUint(const std::string& name, GLuint value);
+	void SetFloat(const std::string& name, GLfloat value);
+	void SetVec2(const std::string& name, const glm::vec2& value);
+	void SetIVec2(const std::string& name, const glm::ivec2& value);
+	void SetVec3(const std::string& name, const glm::vec3& value);
+	void SetVec4(const std::string& name, const glm::vec4& value);
+	void SetMat4(const std::string& name, const glm::mat4& value);
+	void SetVec4Array(const std::string& name, const glm::vec4* values, GLsizei count);
+	void SetMat4Array(const std::string& name, const glm::mat4* values, GLsizei count);
+
+	// Counters shared by every shader, reset by whoever reports them
+	static GLuint uniformUploads;
+	static GLuint elidedUploads;
+private:
+	std::unordered_map<std::string, GLint> uniformLocations;
+	std::unordered_map<GLint, std::vector<unsigned char>> uniformValues;
+	void ReflectUniforms();
+	bool UniformChanged(GLint location, const void* data, size_t size);
 };
\ No newline at end of file
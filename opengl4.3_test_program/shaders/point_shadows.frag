@@ -1,34 +1,80 @@
 #version 430 core
+#ifdef BINDLESS_TEXTURES
+#extension GL_ARB_bindless_texture : require
+#endif
 out vec4 FragColor;
 
 in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
+    vec2 LightmapCoords;
+    flat int Material;
 } fs_in;
 
+#ifdef BINDLESS_TEXTURES
+// resident diffuse texture handles, keep in sync with MaterialTable
+layout (std430, binding = 17) readonly buffer Materials
+{
+	uvec2 diffuseHandles[];
+};
+#else
 uniform sampler2D diffuseTexture;
+#endif
 uniform samplerCube depthMap;
+uniform sampler2DArray shadowMask;
+uniform sampler2D lightmap;
+
+// per view data, keep in sync with FrameData in 源.cpp
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
 
-uniform vec3 lightPos;
-uniform vec3 viewPos;
+// per light data, keep in sync with LightData in 源.cpp
+layout (std140, binding = 1) uniform LightData
+{
+	mat4 shadowMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
 
-uniform float far_plane;
+#define SHADOW_CUBE_MAP 0
+#define SHADOW_RAY_TRACED 1
+#define SHADOW_UNLIT 2
+#define SHADOW_LIT 3
+#define SHADOW_BAKED 4
+uniform int shadowMode;
 
 float ShadowCalculation(vec3 fragPos)
 {
+	if (shadowMode == SHADOW_RAY_TRACED)
+		return texelFetch(shadowMask, ivec3(gl_FragCoord.xy, 0), 0).r;
+	if (shadowMode == SHADOW_UNLIT)
+		return 1.0;
+	if (shadowMode == SHADOW_LIT)
+		return 0.0;
     vec3 fragToLight = fragPos - lightPos;
 	float closestDepth = texture(depthMap, fragToLight).r;
 	closestDepth *= far_plane;
 	float currentDepth = length(fragPos - lightPos);
 	float bias = 0.05;
 	float shadow = currentDepth -  bias > closestDepth ? 1.0 : 0.0;
+	// the cube map only holds dynamic casters, static ones are baked
+	if (shadowMode == SHADOW_BAKED && fs_in.LightmapCoords.x >= 0.0)
+		shadow = max(shadow, texture(lightmap, fs_in.LightmapCoords).r);
     return shadow;
 }
 
 void main()
 {           
+#ifdef BINDLESS_TEXTURES
+    vec3 color = texture(sampler2D(diffuseHandles[fs_in.Material]), fs_in.TexCoords).rgb;
+#else
     vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+#endif
     vec3 normal = normalize(fs_in.Normal);
     vec3 lightColor = vec3(0.3);
     vec3 ambient = 0.3 * color;
@@ -1,29 +1,78 @@
 #version 430 core
-layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
-layout (location = 2) in vec2 texCoords;
+// per instance
+layout (location = 3) in mat4 model;
+layout (location = 7) in mat3 normalMatrix;
+layout (location = 10) in int lightmapTile;
+layout (location = 11) in int material;
 
 out vec2 TexCoords;
 
+// vertices pulled from the geometry heap by gl_VertexID
+layout (std430, binding = 14) readonly buffer GeometryVertices
+{
+	uvec4 vertexData[];
+};
+#include "vertex_format.glsl"
+// per vertex lightmap coordinates of pre-transformed static batches, (-1, -1) elsewhere
+layout (std430, binding = 15) readonly buffer GeometryLightmapCoords
+{
+	vec2 lightmapCoords[];
+};
+
 out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
+    vec2 LightmapCoords;
+    flat int Material;
 } vs_out;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+// per view data, keep in sync with FrameData in 源.cpp
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
 
-uniform bool reverse_normals;
+uniform int lightmapTilesPerRow;
+uniform float lightmapTileSize;
+
+// cube faces are lightmap charts, one tile each in +X, -X, +Y, -Y, +Z, -Z order
+int CubeFace(vec3 n)
+{
+	vec3 a = abs(n);
+	int axis = 0;
+	if (a.y > a[axis])
+		axis = 1;
+	if (a.z > a[axis])
+		axis = 2;
+	return axis * 2 + (n[axis] < 0.0 ? 1 : 0);
+}
 
 void main()
 {
+	uvec4 vertex = vertexData[gl_VertexID];
+	vec3 position = UnpackPosition(vertex.xy);
+	vec3 normal = UnpackNormal(vertex.z);
+	vec2 texCoords = unpackHalf2x16(vertex.w);
+
 	gl_Position = projection * view * model * vec4(position, 1.0f);
 	vs_out.FragPos = vec3(model * vec4(position, 1.0));
-	if(reverse_normals)
-        vs_out.Normal = transpose(inverse(mat3(model))) * (-1.0 * normal);
-	else
-		 vs_out.Normal = transpose(inverse(mat3(model))) * normal;
+#ifdef REVERSE_NORMALS
+	// reverse normal to irradiate room(inside)
+	vs_out.Normal = normalMatrix * (-1.0 * normal);
+#else
+	vs_out.Normal = normalMatrix * normal;
+#endif
 	vs_out.TexCoords = texCoords;
+	vs_out.Material = material;
+	if (lightmapTile >= 0)
+	{
+		int tile = lightmapTile + CubeFace(normal);
+		vec2 origin = vec2(tile % lightmapTilesPerRow, tile / lightmapTilesPerRow) * lightmapTileSize;
+		vs_out.LightmapCoords = (origin + 0.5 + texCoords * (lightmapTileSize - 1.0)) / (lightmapTilesPerRow * lightmapTileSize);
+	}
+	else
+		vs_out.LightmapCoords = lightmapCoords[gl_VertexID];
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #version 430 core
 in vec4 FragPos;
 
-uniform vec3 lightPos;
-uniform float far_plane;
+// per light data, keep in sync with LightData in 源.cpp
+layout (std140, binding = 1) uniform LightData
+{
+	mat4 shadowMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
 
 void main()
 {
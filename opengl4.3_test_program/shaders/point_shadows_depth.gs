@@ -2,7 +2,15 @@
 layout (triangles) in;
 layout (triangle_strip, max_vertices=18) out;
 
-uniform mat4 shadowMatrices[6];
+// per light data, keep in sync with LightData in 源.cpp
+layout (std140, binding = 1) uniform LightData
+{
+	mat4 shadowMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
+// faces no visible receiver samples are skipped
+uniform int faceMask;
 
 out vec4 FragPos;
 
@@ -10,6 +18,8 @@ void main()
 {
 	for(int face = 0; face < 6; face++)
 	{
+		if ((faceMask & (1 << face)) == 0)
+			continue;
 		gl_Layer = face;
 		for(int i = 0; i < 3; i++)
 		{
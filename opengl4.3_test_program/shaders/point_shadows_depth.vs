@@ -1,9 +1,15 @@
 #version 430 core
-layout (location = 0) in vec3 position;
+// per instance
+layout (location = 3) in mat4 model;
 
-uniform mat4 model;
+// depth only positions pulled from the geometry heap by gl_VertexID
+layout (std430, binding = 19) readonly buffer GeometryPositions
+{
+	uvec2 positions[];
+};
+#include "vertex_format.glsl"
 
 void main()
 {
-    gl_Position = model * vec4(position, 1.0);
+    gl_Position = model * vec4(UnpackPosition(positions[gl_VertexID]), 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 430 core
+layout (location = 0) in vec3 position;
+
+// per light data, keep in sync with LightData in 源.cpp
+layout (std140, binding = 1) uniform LightData
+{
+	mat4 shadowMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
+
+// per draw data, keep in sync with DrawData in 源.cpp
+layout (std140, binding = 2) uniform DrawData
+{
+	int face;
+};
+
+out vec4 FragPos;
+
+void main()
+{
+	FragPos = vec4(position, 1.0);
+	gl_Position = shadowMatrices[face] * FragPos;
+}
@@ -0,0 +1,32 @@
+#version 430 core
+// per instance
+layout (location = 3) in mat4 model;
+
+// depth only positions pulled from the geometry heap by gl_VertexID
+layout (std430, binding = 19) readonly buffer GeometryPositions
+{
+	uvec2 positions[];
+};
+#include "vertex_format.glsl"
+
+// per light data, keep in sync with LightData in 源.cpp
+layout (std140, binding = 1) uniform LightData
+{
+	mat4 shadowMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
+
+// per draw data, keep in sync with DrawData in 源.cpp
+layout (std140, binding = 2) uniform DrawData
+{
+	int face;
+};
+
+out vec4 FragPos;
+
+void main()
+{
+	FragPos = model * vec4(UnpackPosition(positions[gl_VertexID]), 1.0);
+	gl_Position = shadowMatrices[face] * FragPos;
+}
@@ -0,0 +1,12 @@
+#version 430 core
+
+uniform usampler2DArray rasterDepth;
+uniform int face;
+
+void main()
+{
+	uint depth = texelFetch(rasterDepth, ivec3(gl_FragCoord.xy, face), 0).r;
+	if (depth == 0xFFFFFFFFu)
+		discard;
+	gl_FragDepth = uintBitsToFloat(depth);
+}
@@ -0,0 +1,15 @@
+#version 430 core
+layout (location = 0) in vec4 position;
+
+// per view data, keep in sync with FrameData in 源.cpp
+layout (std140, binding = 0) uniform FrameData
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+void main()
+{
+	gl_Position = projection * view * position;
+}
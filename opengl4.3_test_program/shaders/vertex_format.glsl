@@ -0,0 +1,35 @@
+// Decoders of the geometry heap's packed vertices, shared by every shader
+// that pulls them; keep in sync with PackedVertex, PackedPosition and
+// QuantizationBounds in vertex_format.h. A shader may define
+// GEOMETRY_BOUNDS_LAYOUT before including this to place the bounds table.
+#ifndef GEOMETRY_BOUNDS_LAYOUT
+#define GEOMETRY_BOUNDS_LAYOUT binding = 18
+#endif
+
+struct QuantizationBounds
+{
+	vec4 origin;
+	vec4 extent;
+};
+layout (std430, GEOMETRY_BOUNDS_LAYOUT) readonly buffer GeometryBounds
+{
+	QuantizationBounds bounds[];
+};
+
+// x and y as unorm16, then z as unorm16 with the bounds entry in the high half
+vec3 UnpackPosition(uvec2 encoded)
+{
+	vec3 unorm = vec3(unpackUnorm2x16(encoded.x), unpackUnorm2x16(encoded.y).x);
+	QuantizationBounds range = bounds[encoded.y >> 16];
+	return range.origin.xyz + unorm * range.extent.xyz;
+}
+
+// the octahedron's lower half is folded over the diagonals
+vec3 UnpackNormal(uint encoded)
+{
+	vec2 e = unpackSnorm2x16(encoded);
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
@@ -0,0 +1,19 @@
+#version 450
+// Vulkan variant of point_shadows_depth.frag
+// the DebugVulkan configuration builds it with: glslangValidator -V depth_cube.frag -o depth_cube.frag.spv
+layout (location = 0) in vec4 FragPos;
+
+// keep in sync with PassData in vulkan_backend.cpp
+layout (std140, set = 0, binding = 1) uniform PassData
+{
+	mat4 faceMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
+
+void main()
+{
+	float lightDistance = length(FragPos.xyz - lightPos);
+	lightDistance /= far_plane;
+	gl_FragDepth = lightDistance;
+}
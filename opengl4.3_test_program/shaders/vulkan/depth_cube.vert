@@ -0,0 +1,34 @@
+#version 450
+#extension GL_EXT_multiview : require
+#extension GL_GOOGLE_include_directive : require
+// Vulkan variant of point_shadows_depth_face_instanced.vs, every view is one cube face.
+// the DebugVulkan configuration builds it with: glslangValidator -V depth_cube.vert -o depth_cube.vert.spv
+
+// per instance
+layout (location = 3) in mat4 model;
+
+// depth only positions pulled by gl_VertexIndex, which includes the base vertex
+layout (std430, set = 0, binding = 0) readonly buffer GeometryPositions
+{
+	uvec2 positions[];
+};
+#define GEOMETRY_BOUNDS_LAYOUT set = 0, binding = 2
+#include "../vertex_format.glsl"
+
+// keep in sync with PassData in vulkan_backend.cpp
+layout (std140, set = 0, binding = 1) uniform PassData
+{
+	mat4 faceMatrices[6];
+	vec3 lightPos;
+	float far_plane;
+};
+
+layout (location = 0) out vec4 FragPos;
+
+void main()
+{
+	FragPos = model * vec4(UnpackPosition(positions[gl_VertexIndex]), 1.0);
+	gl_Position = faceMatrices[gl_ViewIndex] * FragPos;
+	// the face matrices are GL's, whose clip depth is -w..w rather than 0..w
+	gl_Position.z = (gl_Position.z + gl_Position.w) * 0.5;
+}
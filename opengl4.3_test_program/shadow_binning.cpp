@@ -0,0 +1,64 @@
+#include "shadow_binning.h"
+#include "gl_state.h"
+
+ShadowBinner::ShadowBinner(ShadowCasters& casters)
+	: casters(casters), binShader("shaders/shadow_binning.comp")
+{
+	faceCapacity = casters.triangleCount * 3;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &faceIndexBuffer);
+	glGenBuffers(1, &indirectBuffer);
+
+	GLState::BindVertexArray(VAO);
+
+	GLState::BindBuffer(GL_ARRAY_BUFFER, casters.positionBuffer);
+
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, faceIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * faceCapacity * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+
+	GLState::BindVertexArray(0);
+
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, 6 * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_COPY);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ShadowBinner::Bin(const vector<glm::mat4>& shadowMatrices, GLuint faceMask)
+{
+	DrawElementsIndirectCommand commands[6];
+	for (GLuint i = 0; i < 6; i++)
+	{
+		commands[i].count = 0;
+		commands[i].instanceCount = 1;
+		commands[i].firstIndex = i * faceCapacity;
+		commands[i].baseVertex = 0;
+		commands[i].baseInstance = 0;
+	}
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(commands), commands);
+
+	binShader.Use();
+	binShader.SetMat4Array("shadowMatrices", &shadowMatrices[0], 6);
+	binShader.SetUint("triangleCount", casters.triangleCount);
+	binShader.SetUint("faceCapacity", faceCapacity);
+	binShader.SetUint("faceMask", faceMask);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, casters.positionBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, faceIndexBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indirectBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, casters.triangleMeshBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, casters.meshPathBuffer);
+	glDispatchCompute((casters.triangleCount + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+}
+
+void ShadowBinner::DrawFace(GLuint face)
+{
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(face * sizeof(DrawElementsIndirectCommand)));
+}
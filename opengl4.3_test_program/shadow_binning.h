@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "shadow_casters.h"
+
+using namespace std;
+
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLuint baseVertex;
+	GLuint baseInstance;
+};
+
+// Bins world space caster triangles into one index list per cube face,
+// so the depth pass can draw each face without geometry shader amplification.
+class ShadowBinner
+{
+public:
+	ShadowBinner(ShadowCasters& casters);
+	void Bin(const vector<glm::mat4>& shadowMatrices, GLuint faceMask);
+	void DrawFace(GLuint face);
+private:
+	ShadowCasters& casters;
+	Shader binShader;
+	GLuint VAO, faceIndexBuffer, indirectBuffer;
+	GLuint faceCapacity;
+};
@@ -0,0 +1,166 @@
+#include "shadow_casters.h"
+#include "gl_state.h"
+
+// meshes whose triangles cover less than this many shadow texels on average go to the compute rasterizer
+const float MICRO_TRIANGLE_TEXELS = 1.0f;
+// a batch ends after this many triangles or at a triangle turned further than the cosine from its first
+const GLuint CASTER_BATCH_TRIANGLES = 16;
+const float CASTER_BATCH_COSINE = 0.7f;
+
+ShadowCasters::ShadowCasters()
+{
+	triangleCount = 0;
+	computeMeshCount = 0;
+	positionBuffer = 0;
+	triangleMeshBuffer = 0;
+	meshPathBuffer = 0;
+	edgeBuffer = 0;
+}
+
+void ShadowCasters::AddTriangles(const vector<glm::vec3>& trianglePositions)
+{
+	vector<unsigned int> indices;
+	for (unsigned int i = 0; i < trianglePositions.size(); i++)
+		indices.push_back(i);
+	vector<Edge> meshEdges;
+	BuildEdgeAdjacency(trianglePositions, indices, meshEdges);
+	AppendMesh(trianglePositions, meshEdges);
+}
+
+void ShadowCasters::AddMesh(const Mesh& mesh, const glm::mat4& model)
+{
+	vector<glm::vec3> trianglePositions;
+	vector<unsigned int> firstCorner(mesh.vertices.size(), NO_ADJACENT_TRIANGLE);
+	for (unsigned int i = 0; i < mesh.indices.size(); i++)
+	{
+		trianglePositions.push_back(glm::vec3(model * glm::vec4(mesh.vertices[mesh.indices[i]].Positon, 1.0f)));
+		if (firstCorner[mesh.indices[i]] == NO_ADJACENT_TRIANGLE)
+			firstCorner[mesh.indices[i]] = i;
+	}
+
+	// the mesh's adjacency refers to vertices, the caster soup to triangle corners
+	vector<Edge> meshEdges;
+	for (unsigned int i = 0; i < mesh.edges.size(); i++)
+	{
+		Edge edge;
+		edge.v0 = firstCorner[mesh.edges[i].v0];
+		edge.v1 = firstCorner[mesh.edges[i].v1];
+		edge.oppositeA = firstCorner[mesh.edges[i].oppositeA];
+		edge.oppositeB = mesh.edges[i].oppositeB == NO_ADJACENT_TRIANGLE ? NO_ADJACENT_TRIANGLE : firstCorner[mesh.edges[i].oppositeB];
+		meshEdges.push_back(edge);
+	}
+	AppendMesh(trianglePositions, meshEdges);
+}
+
+void ShadowCasters::AppendMesh(const vector<glm::vec3>& trianglePositions, const vector<Edge>& meshEdges)
+{
+	GLuint firstCorner = positions.size();
+	for (unsigned int i = 0; i < meshEdges.size(); i++)
+	{
+		Edge edge = meshEdges[i];
+		edge.v0 += firstCorner;
+		edge.v1 += firstCorner;
+		edge.oppositeA += firstCorner;
+		if (edge.oppositeB != NO_ADJACENT_TRIANGLE)
+			edge.oppositeB += firstCorner;
+		edges.push_back(edge);
+	}
+
+	ShadowCasterMesh mesh;
+	mesh.firstTriangle = triangleCount;
+	mesh.triangleCount = trianglePositions.size() / 3;
+	mesh.computeRaster = false;
+
+	glm::vec3 minBound(trianglePositions[0]), maxBound(trianglePositions[0]);
+	for (unsigned int i = 0; i < trianglePositions.size(); i++)
+	{
+		minBound = glm::min(minBound, trianglePositions[i]);
+		maxBound = glm::max(maxBound, trianglePositions[i]);
+		positions.push_back(glm::vec4(trianglePositions[i], 1.0f));
+	}
+	mesh.center = (minBound + maxBound) * 0.5f;
+	mesh.radius = glm::length(maxBound - mesh.center);
+
+	mesh.area = 0.0f;
+	mesh.firstBatch = batches.size();
+	glm::vec3 batchNormal(0.0f);
+	GLuint batchTriangles = 0;
+	for (unsigned int i = 0; i + 2 < trianglePositions.size(); i += 3)
+	{
+		glm::vec3 cross = glm::cross(trianglePositions[i + 1] - trianglePositions[i], trianglePositions[i + 2] - trianglePositions[i]);
+		float length = glm::length(cross);
+		mesh.area += 0.5f * length;
+		glm::vec3 normal = length > 0.0f ? cross / length : batchNormal;
+		if (batchTriangles == 0 || batchTriangles == CASTER_BATCH_TRIANGLES || glm::dot(normal, batchNormal) < CASTER_BATCH_COSINE)
+		{
+			ShadowCasterBatch batch;
+			batch.minBound = batch.maxBound = trianglePositions[i];
+			batches.push_back(batch);
+			batchNormal = normal;
+			batchTriangles = 0;
+		}
+		ShadowCasterBatch& batch = batches.back();
+		for (unsigned int v = 0; v < 3; v++)
+		{
+			batch.minBound = glm::min(batch.minBound, trianglePositions[i + v]);
+			batch.maxBound = glm::max(batch.maxBound, trianglePositions[i + v]);
+		}
+		batchTriangles++;
+	}
+	mesh.batchCount = batches.size() - mesh.firstBatch;
+
+	triangleCount += mesh.triangleCount;
+	meshes.push_back(mesh);
+}
+
+void ShadowCasters::Upload()
+{
+	vector<GLuint> triangleMesh;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		triangleMesh.insert(triangleMesh.end(), meshes[i].triangleCount, i);
+	vector<GLuint> meshPath(meshes.size(), 0);
+
+	glGenBuffers(1, &positionBuffer);
+	glGenBuffers(1, &triangleMeshBuffer);
+	glGenBuffers(1, &meshPathBuffer);
+	glGenBuffers(1, &edgeBuffer);
+
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, positionBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, positions.size() * sizeof(glm::vec4), &positions[0], GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, triangleMeshBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, triangleMesh.size() * sizeof(GLuint), &triangleMesh[0], GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, meshPathBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshPath.size() * sizeof(GLuint), &meshPath[0], GL_DYNAMIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, edgeBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, edges.size() * sizeof(Edge), edges.empty() ? NULL : &edges[0], GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void ShadowCasters::SelectRasterPaths(glm::vec3 lightPos, float near, GLuint faceSize)
+{
+	bool changed = false;
+	computeMeshCount = 0;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		// a 90 degree face spans 2 * distance world units at that distance
+		float distance = glm::max(glm::length(meshes[i].center - lightPos) - meshes[i].radius, near);
+		float texelsPerUnit = faceSize / (2.0f * distance);
+		float triangleTexels = meshes[i].area / meshes[i].triangleCount * texelsPerUnit * texelsPerUnit;
+		bool computeRaster = triangleTexels < MICRO_TRIANGLE_TEXELS;
+		if (computeRaster != meshes[i].computeRaster)
+			changed = true;
+		meshes[i].computeRaster = computeRaster;
+		if (computeRaster)
+			computeMeshCount++;
+	}
+
+	if (changed)
+	{
+		vector<GLuint> meshPath;
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			meshPath.push_back(meshes[i].computeRaster ? 1 : 0);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, meshPathBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, meshPath.size() * sizeof(GLuint), &meshPath[0]);
+		GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
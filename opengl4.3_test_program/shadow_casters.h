@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "mesh.h"
+
+using namespace std;
+
+// a run of a mesh's triangles facing roughly the same way, bounded for culling
+struct ShadowCasterBatch
+{
+	glm::vec3 minBound, maxBound;
+};
+
+struct ShadowCasterMesh
+{
+	GLuint firstTriangle;
+	GLuint triangleCount;
+	GLuint firstBatch;
+	GLuint batchCount;
+	glm::vec3 center;
+	float radius;
+	float area;
+	bool computeRaster;
+};
+
+// World space triangles of every shadow caster, grouped per mesh so the
+// depth pass can pick hardware or compute rasterization mesh by mesh.
+class ShadowCasters
+{
+public:
+	ShadowCasters();
+	void AddTriangles(const vector<glm::vec3>& trianglePositions);
+	void AddMesh(const Mesh& mesh, const glm::mat4& model);
+	void Upload();
+	void SelectRasterPaths(glm::vec3 lightPos, float near, GLuint faceSize);
+	vector<ShadowCasterMesh> meshes;
+	vector<ShadowCasterBatch> batches;
+	vector<glm::vec4> positions;
+	vector<Edge> edges;
+	GLuint triangleCount;
+	GLuint computeMeshCount;
+	GLuint positionBuffer, triangleMeshBuffer, meshPathBuffer, edgeBuffer;
+private:
+	void AppendMesh(const vector<glm::vec3>& trianglePositions, const vector<Edge>& meshEdges);
+};
@@ -0,0 +1,84 @@
+#include "shadow_face_culling.h"
+
+// world space planes of a clip space frustum, normalized so a distance can be
+// compared against a radius; near and far are left out when only the sides matter
+static int FrustumPlanes(const glm::mat4& matrix, float shrink, bool depthPlanes, glm::vec4* planes)
+{
+	glm::mat4 t = glm::transpose(matrix);
+	int count = 0;
+	planes[count++] = t[3] * (1.0f - shrink) + t[0];
+	planes[count++] = t[3] * (1.0f - shrink) - t[0];
+	planes[count++] = t[3] * (1.0f - shrink) + t[1];
+	planes[count++] = t[3] * (1.0f - shrink) - t[1];
+	if (depthPlanes)
+	{
+		planes[count++] = t[3] + t[2];
+		planes[count++] = t[3] - t[2];
+	}
+	for (int p = 0; p < count; p++)
+		planes[p] /= glm::length(glm::vec3(planes[p]));
+	return count;
+}
+
+// false when the box lies entirely behind one of the planes
+static bool BoxInPlanes(const glm::vec4* planes, int planeCount, glm::vec3 minBound, glm::vec3 maxBound)
+{
+	for (int p = 0; p < planeCount; p++)
+	{
+		glm::vec3 normal(planes[p]);
+		// the corner furthest along the normal
+		glm::vec3 corner(normal.x >= 0.0f ? maxBound.x : minBound.x, normal.y >= 0.0f ? maxBound.y : minBound.y, normal.z >= 0.0f ? maxBound.z : minBound.z);
+		if (glm::dot(normal, corner) + planes[p].w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+GLuint VisibleShadowFaces(const ShadowCasters& receivers, const glm::mat4& viewProjection, const vector<glm::mat4>& shadowMatrices)
+{
+	glm::vec4 viewPlanes[6];
+	int viewPlaneCount = FrustumPlanes(viewProjection, 0.0f, true, viewPlanes);
+
+	// receiver boxes are first clipped to the box around the view frustum
+	glm::mat4 invViewProjection = glm::inverse(viewProjection);
+	glm::vec3 viewMin(1e30f), viewMax(-1e30f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 ndc(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f, 1.0f);
+		glm::vec4 world = invViewProjection * ndc;
+		viewMin = glm::min(viewMin, glm::vec3(world) / world.w);
+		viewMax = glm::max(viewMax, glm::vec3(world) / world.w);
+	}
+
+	// faces are shrunk a little so a receiver that only touches a face edge does not count
+	glm::vec4 facePlanes[6][4];
+	for (int face = 0; face < 6; face++)
+		FrustumPlanes(shadowMatrices[face], 1e-4f, false, facePlanes[face]);
+
+	GLuint mask = 0;
+	for (unsigned int m = 0; m < receivers.meshes.size() && mask != ALL_SHADOW_FACES; m++)
+	{
+		const ShadowCasterMesh& mesh = receivers.meshes[m];
+		bool culled = false;
+		for (int p = 0; p < viewPlaneCount && !culled; p++)
+			culled = glm::dot(viewPlanes[p], glm::vec4(mesh.center, 1.0f)) < -mesh.radius;
+		if (culled)
+			continue;
+
+		for (GLuint b = mesh.firstBatch; b < mesh.firstBatch + mesh.batchCount && mask != ALL_SHADOW_FACES; b++)
+		{
+			const ShadowCasterBatch& batch = receivers.batches[b];
+			glm::vec3 minBound = glm::max(batch.minBound, viewMin);
+			glm::vec3 maxBound = glm::min(batch.maxBound, viewMax);
+			if (glm::any(glm::greaterThan(minBound, maxBound)) || !BoxInPlanes(viewPlanes, viewPlaneCount, minBound, maxBound))
+				continue;
+
+			for (int face = 0; face < 6; face++)
+			{
+				if (!(mask & (1 << face)) && BoxInPlanes(facePlanes[face], 4, minBound, maxBound))
+					mask |= 1 << face;
+			}
+		}
+	}
+	return mask;
+}
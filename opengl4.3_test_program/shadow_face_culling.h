@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shadow_casters.h"
+
+using namespace std;
+
+const GLuint ALL_SHADOW_FACES = 0x3F;
+
+// Returns a mask with bit i set when cube face i (GL_TEXTURE_CUBE_MAP_POSITIVE_X + i)
+// may be sampled by a receiver inside the view frustum. Receivers are tested
+// batch by batch as bounding boxes, so the mask is conservative. Every caster
+// in this scene is also a receiver, so the caster soup is the receiver set.
+GLuint VisibleShadowFaces(const ShadowCasters& receivers, const glm::mat4& viewProjection, const vector<glm::mat4>& shadowMatrices);
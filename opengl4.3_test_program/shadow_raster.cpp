@@ -0,0 +1,64 @@
+#include "shadow_raster.h"
+#include "gl_state.h"
+
+ShadowRasterizer::ShadowRasterizer(ShadowCasters& casters, GLuint width, GLuint height)
+	: casters(casters),
+	clearShader("shaders/shadow_raster_clear.comp"),
+	rasterShader("shaders/shadow_raster.comp"),
+	resolveShader("shaders/shadow_raster_resolve.vs", "shaders/shadow_raster_resolve.frag")
+{
+	this->width = width;
+	this->height = height;
+
+	glGenTextures(1, &rasterDepth);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, rasterDepth);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R32UI, width, height, 6);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// the resolve pass builds its fullscreen triangle from gl_VertexID
+	glGenVertexArrays(1, &VAO);
+
+	resolveShader.Use();
+	resolveShader.SetInt("rasterDepth", 0);
+}
+
+void ShadowRasterizer::Raster(const vector<glm::mat4>& shadowMatrices, GLuint faceMask, glm::vec3 lightPos, float far)
+{
+	glBindImageTexture(0, rasterDepth, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+
+	clearShader.Use();
+	for (GLuint face = 0; face < 6; face++)
+	{
+		if ((faceMask & (1 << face)) == 0)
+			continue;
+		clearShader.SetInt("face", face);
+		glDispatchCompute((width + 7) / 8, (height + 7) / 8, 1);
+	}
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	rasterShader.Use();
+	rasterShader.SetMat4Array("shadowMatrices", &shadowMatrices[0], 6);
+	rasterShader.SetVec3("lightPos", lightPos);
+	rasterShader.SetFloat("far_plane", far);
+	rasterShader.SetUint("triangleCount", casters.triangleCount);
+	rasterShader.SetUint("faceMask", faceMask);
+	rasterShader.SetVec2("faceSize", glm::vec2(width, height));
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, casters.positionBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, casters.triangleMeshBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, casters.meshPathBuffer);
+	glDispatchCompute((casters.triangleCount + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void ShadowRasterizer::Resolve(GLuint face)
+{
+	resolveShader.Use();
+	resolveShader.SetInt("face", face);
+	GLState::ActiveTexture(GL_TEXTURE0);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, rasterDepth);
+	GLState::BindVertexArray(VAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "shadow_casters.h"
+
+using namespace std;
+
+// Rasterizes micro triangle casters in a compute shader with atomic min depth,
+// then resolves the result into the depth cube map face by face.
+class ShadowRasterizer
+{
+public:
+	ShadowRasterizer(ShadowCasters& casters, GLuint width, GLuint height);
+	// faces outside faceMask are neither cleared nor rasterized, see VisibleShadowFaces
+	void Raster(const vector<glm::mat4>& shadowMatrices, GLuint faceMask, glm::vec3 lightPos, float far);
+	void Resolve(GLuint face);
+	GLuint rasterDepth;
+private:
+	ShadowCasters& casters;
+	Shader clearShader, rasterShader, resolveShader;
+	GLuint VAO;
+	GLuint width, height;
+};
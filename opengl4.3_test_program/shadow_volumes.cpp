@@ -0,0 +1,59 @@
+#include "shadow_volumes.h"
+#include "gl_state.h"
+
+ShadowVolumes::ShadowVolumes(ShadowCasters& casters)
+	: casters(casters),
+	extractShader("shaders/shadow_volume_extract.comp"),
+	volumeShader("shaders/shadow_volume.vs", "shaders/depth_prepass.frag")
+{
+	// every edge can become a quad and every triangle a front and a back cap
+	GLuint maxVertices = casters.edges.size() * 6 + casters.triangleCount * 6;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &volumeBuffer);
+	glGenBuffers(1, &indirectBuffer);
+
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, volumeBuffer);
+	glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(glm::vec4), NULL, GL_DYNAMIC_COPY);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+	GLState::BindVertexArray(0);
+
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawArraysIndirectCommand), NULL, GL_DYNAMIC_COPY);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ShadowVolumes::Extract(glm::vec3 lightPos)
+{
+	DrawArraysIndirectCommand command;
+	command.count = 0;
+	command.instanceCount = 1;
+	command.first = 0;
+	command.baseInstance = 0;
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+
+	GLuint edgeCount = casters.edges.size();
+	extractShader.Use();
+	extractShader.SetVec3("lightPos", lightPos);
+	extractShader.SetUint("edgeCount", edgeCount);
+	extractShader.SetUint("triangleCount", casters.triangleCount);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, casters.positionBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, casters.edgeBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, volumeBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, indirectBuffer);
+	glDispatchCompute((glm::max(edgeCount, casters.triangleCount) + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void ShadowVolumes::Draw()
+{
+	volumeShader.Use();
+
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glDrawArraysIndirect(GL_TRIANGLES, 0);
+}
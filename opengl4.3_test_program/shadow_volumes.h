@@ -0,0 +1,29 @@
+#pragma once
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "shader.h"
+#include "shadow_casters.h"
+
+struct DrawArraysIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint first;
+	GLuint baseInstance;
+};
+
+// Extracts silhouette edges relative to the light in a compute shader and
+// extrudes them, together with front and back caps, into closed shadow
+// volumes for z-fail stencil shadows.
+class ShadowVolumes
+{
+public:
+	ShadowVolumes(ShadowCasters& casters);
+	void Extract(glm::vec3 lightPos);
+	// projection and view come from the FrameData uniform block
+	void Draw();
+private:
+	ShadowCasters& casters;
+	Shader extractShader, volumeShader;
+	GLuint VAO, volumeBuffer, indirectBuffer;
+};
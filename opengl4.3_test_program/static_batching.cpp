@@ -0,0 +1,77 @@
+#include "static_batching.h"
+
+StaticBatcher::StaticBatcher()
+{
+	sourceCount = 0;
+}
+
+void StaticBatcher::Add(const StaticMaterial& material, const vector<Vertex>& vertices, const vector<GLuint>& indices, const glm::mat4& model, const vector<glm::vec2>& lightmapCoords)
+{
+	// a full batch is closed and the material continues in a new one, so
+	// every batch fits a heap range with 16 bit indices
+	PendingBatch* batch = NULL;
+	for (unsigned int i = 0; i < pending.size(); i++)
+	{
+		if (pending[i].material.texture == material.texture && pending[i].material.reverse_normals == material.reverse_normals
+			&& pending[i].vertices.size() + vertices.size() <= GEOMETRY_RANGE_MAX_VERTICES)
+			batch = &pending[i];
+	}
+	if (!batch)
+	{
+		PendingBatch newBatch;
+		newBatch.material = material;
+		newBatch.sourceCount = 0;
+		pending.push_back(newBatch);
+		batch = &pending.back();
+	}
+
+	GLuint baseVertex = batch->vertices.size();
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+	for (unsigned int i = 0; i < vertices.size(); i++)
+	{
+		Vertex vertex = vertices[i];
+		vertex.Positon = glm::vec3(model * glm::vec4(vertex.Positon, 1.0f));
+		vertex.Normal = glm::normalize(normalMatrix * vertex.Normal);
+		batch->vertices.push_back(vertex);
+		batch->lightmapCoords.push_back(lightmapCoords.empty() ? glm::vec2(-1.0f) : lightmapCoords[i]);
+	}
+	for (unsigned int i = 0; i < indices.size(); i++)
+		batch->indices.push_back(baseVertex + indices[i]);
+	batch->sourceCount++;
+	sourceCount++;
+}
+
+void StaticBatcher::AddMesh(const Mesh& mesh, const glm::mat4& model, bool reverse_normals)
+{
+	StaticMaterial material;
+	material.texture = mesh.textures.empty() ? 0 : mesh.textures[0].id;
+	material.reverse_normals = reverse_normals;
+	Add(material, mesh.vertices, mesh.indices, model, vector<glm::vec2>());
+}
+
+void StaticBatcher::Build(GeometryHeap& heap)
+{
+	for (unsigned int i = 0; i < pending.size(); i++)
+	{
+		PendingBatch& source = pending[i];
+		if (source.vertices.empty())
+			continue;
+		StaticBatch batch;
+		batch.material = source.material;
+		batch.sourceCount = source.sourceCount;
+		batch.geometry = heap.Allocate(source.vertices.data(), source.vertices.size(), source.indices.data(), source.indices.size(), source.lightmapCoords.data());
+
+		glm::vec3 minBound(source.vertices[0].Positon), maxBound(source.vertices[0].Positon);
+		for (unsigned int v = 1; v < source.vertices.size(); v++)
+		{
+			minBound = glm::min(minBound, source.vertices[v].Positon);
+			maxBound = glm::max(maxBound, source.vertices[v].Positon);
+		}
+		batch.center = (minBound + maxBound) * 0.5f;
+		batch.radius = 0.0f;
+		for (unsigned int v = 0; v < source.vertices.size(); v++)
+			batch.radius = glm::max(batch.radius, glm::length(source.vertices[v].Positon - batch.center));
+		batches.push_back(batch);
+	}
+	pending.clear();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "mesh.h"
+#include "geometry_heap.h"
+
+using namespace std;
+
+// render state static geometry is merged by
+struct StaticMaterial
+{
+	GLuint texture;
+	bool reverse_normals;
+};
+
+// pre-transformed geometry of every static object sharing a material
+struct StaticBatch
+{
+	StaticMaterial material;
+	GeometryRange geometry;
+	// world space bounding sphere
+	glm::vec3 center;
+	GLfloat radius;
+	// objects merged into the batch
+	GLuint sourceCount;
+};
+
+// Merges non-moving geometry into pre-transformed vertex and index ranges
+// per material at load time, so every static material is a single draw per
+// pass, or one per GEOMETRY_RANGE_MAX_VERTICES, instead of one draw, or one
+// instanced batch, per object.
+class StaticBatcher
+{
+public:
+	StaticBatcher();
+	// lightmapCoords may be empty for geometry without a baked lightmap
+	void Add(const StaticMaterial& material, const vector<Vertex>& vertices, const vector<GLuint>& indices, const glm::mat4& model, const vector<glm::vec2>& lightmapCoords);
+	void AddMesh(const Mesh& mesh, const glm::mat4& model, bool reverse_normals);
+	void Build(GeometryHeap& heap);
+	vector<StaticBatch> batches;
+	// objects added, the draw count per pass without batching
+	GLuint sourceCount;
+private:
+	struct PendingBatch
+	{
+		StaticMaterial material;
+		vector<Vertex> vertices;
+		vector<GLuint> indices;
+		vector<glm::vec2> lightmapCoords;
+		GLuint sourceCount;
+	};
+	vector<PendingBatch> pending;
+};
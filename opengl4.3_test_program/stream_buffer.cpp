@@ -0,0 +1,98 @@
+#include "stream_buffer.h"
+#include "gl_state.h"
+#include <iostream>
+#include <cstring>
+
+StreamBuffer::StreamBuffer(GLsizeiptr frameSize)
+{
+	// one alignment that suits every binding target the ranges are used with
+	GLint uniformAlignment, storageAlignment;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	alignment = uniformAlignment > storageAlignment ? uniformAlignment : storageAlignment;
+	this->frame = 0;
+	this->head = 0;
+	for (int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+		fences[i] = 0;
+	Allocate(frameSize);
+}
+
+void StreamBuffer::Allocate(GLsizeiptr frameSize)
+{
+	this->frameSize = (frameSize + alignment - 1) / alignment * alignment;
+	GLsizeiptr size = this->frameSize * STREAM_BUFFER_FRAMES;
+	glGenBuffers(1, &buffer);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	if (GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+		mapped = (GLubyte*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+	}
+	else
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+		mapped = NULL;
+	}
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::Grow(GLsizeiptr required)
+{
+	GLsizeiptr grown = frameSize * 2;
+	while (grown < required)
+		grown *= 2;
+	// the new buffer's regions are unused, so its frames need no fences
+	retired.push_back(buffer);
+	Allocate(grown);
+	std::cout << "stream buffer: frame region grown to " << frameSize << " bytes" << std::endl;
+}
+
+void StreamBuffer::BeginFrame()
+{
+	if (fences[frame])
+	{
+		// only blocks when the GPU is more than STREAM_BUFFER_FRAMES frames behind
+		GLenum result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		glDeleteSync(fences[frame]);
+		fences[frame] = 0;
+	}
+	// nothing this frame draws reads a retired buffer, GL frees it once the GPU is done
+	for (unsigned int i = 0; i < retired.size(); i++)
+		GLState::DeleteBuffer(retired[i]);
+	retired.clear();
+	head = 0;
+}
+
+void StreamBuffer::EndFrame()
+{
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % STREAM_BUFFER_FRAMES;
+}
+
+GLintptr StreamBuffer::Write(const void* data, GLsizeiptr size)
+{
+	if (head + size > frameSize)
+		Grow(head + size);
+	GLintptr offset = frame * frameSize + head;
+	if (mapped)
+		std::memcpy(mapped + offset, data, size);
+	else
+	{
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		void* range = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		std::memcpy(range, data, size);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	head += (size + alignment - 1) / alignment * alignment;
+	return offset;
+}
+
+void StreamBuffer::Bind(GLenum target, GLuint binding, const void* data, GLsizeiptr size)
+{
+	GLintptr offset = Write(data, size);
+	GLState::BindBufferRange(target, binding, buffer, offset, size);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+
+using namespace std;
+
+const int STREAM_BUFFER_FRAMES = 3;
+
+// Buffer for per-frame and per-draw transient data, split into one region per
+// frame in flight. With ARB_buffer_storage it stays persistently and
+// coherently mapped, otherwise each write maps its range unsynchronized.
+// A region is only rewritten after the fence of the frame that last used it
+// has signalled, so writes never wait on the GPU in steady state. A frame
+// that outgrows its region moves the buffer to a larger one, the old buffer
+// stays alive for the ranges already bound from it until the next frame.
+class StreamBuffer
+{
+public:
+	StreamBuffer(GLsizeiptr frameSize);
+	void BeginFrame();
+	void EndFrame();
+	// Sub-allocates size bytes from this frame's region, copies data in and returns the offset
+	GLintptr Write(const void* data, GLsizeiptr size);
+	// Writes data and binds the range to an indexed uniform or shader storage binding
+	void Bind(GLenum target, GLuint binding, const void* data, GLsizeiptr size);
+	GLuint buffer;
+private:
+	void Allocate(GLsizeiptr frameSize);
+	void Grow(GLsizeiptr required);
+	GLubyte* mapped;
+	GLsizeiptr frameSize;
+	GLint alignment;
+	int frame;
+	GLintptr head;
+	GLsync fences[STREAM_BUFFER_FRAMES];
+	vector<GLuint> retired;
+};
@@ -0,0 +1,76 @@
+#include "transform_stage.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define TRANSFORM_STAGE_SSE
+#include <xmmintrin.h>
+#endif
+
+// the inverse transpose of [a b c] is [b x c, c x a, a x b] / dot(a, b x c)
+static void NormalMatrix(const glm::mat4& model, glm::mat3& normalMatrix)
+{
+	glm::vec3 a(model[0]), b(model[1]), c(model[2]);
+	glm::vec3 bc = glm::cross(b, c);
+	GLfloat invDet = 1.0f / glm::dot(a, bc);
+	normalMatrix[0] = bc * invDet;
+	normalMatrix[1] = glm::cross(c, a) * invDet;
+	normalMatrix[2] = glm::cross(a, b) * invDet;
+}
+
+#ifdef TRANSFORM_STAGE_SSE
+struct Vec3x4
+{
+	__m128 x, y, z;
+};
+
+static inline Vec3x4 Cross(const Vec3x4& u, const Vec3x4& v)
+{
+	Vec3x4 r;
+	r.x = _mm_sub_ps(_mm_mul_ps(u.y, v.z), _mm_mul_ps(u.z, v.y));
+	r.y = _mm_sub_ps(_mm_mul_ps(u.z, v.x), _mm_mul_ps(u.x, v.z));
+	r.z = _mm_sub_ps(_mm_mul_ps(u.x, v.y), _mm_mul_ps(u.y, v.x));
+	return r;
+}
+
+// column c of four matrices, transposed so each register holds one component of all four
+static inline Vec3x4 LoadColumn(const glm::mat4* models, int column)
+{
+	__m128 c0 = _mm_loadu_ps(&models[0][column][0]);
+	__m128 c1 = _mm_loadu_ps(&models[1][column][0]);
+	__m128 c2 = _mm_loadu_ps(&models[2][column][0]);
+	__m128 c3 = _mm_loadu_ps(&models[3][column][0]);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	Vec3x4 v = { c0, c1, c2 };
+	return v;
+}
+
+static inline void StoreColumn(glm::mat3* normalMatrices, int column, const Vec3x4& v, __m128 invDet)
+{
+	GLfloat x[4], y[4], z[4];
+	_mm_storeu_ps(x, _mm_mul_ps(v.x, invDet));
+	_mm_storeu_ps(y, _mm_mul_ps(v.y, invDet));
+	_mm_storeu_ps(z, _mm_mul_ps(v.z, invDet));
+	for (int i = 0; i < 4; i++)
+		normalMatrices[i][column] = glm::vec3(x[i], y[i], z[i]);
+}
+#endif
+
+void ComputeNormalMatrices(const glm::mat4* models, glm::mat3* normalMatrices, size_t count)
+{
+	size_t i = 0;
+#ifdef TRANSFORM_STAGE_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		Vec3x4 a = LoadColumn(models + i, 0);
+		Vec3x4 b = LoadColumn(models + i, 1);
+		Vec3x4 c = LoadColumn(models + i, 2);
+		Vec3x4 bc = Cross(b, c);
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, bc.x), _mm_mul_ps(a.y, bc.y)), _mm_mul_ps(a.z, bc.z));
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		StoreColumn(normalMatrices + i, 0, bc, invDet);
+		StoreColumn(normalMatrices + i, 1, Cross(c, a), invDet);
+		StoreColumn(normalMatrices + i, 2, Cross(a, b), invDet);
+	}
+#endif
+	for (; i < count; i++)
+		NormalMatrix(models[i], normalMatrices[i]);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+
+// Computes transpose(inverse(mat3(model))) for every instance, four
+// instances per SSE batch, so no vertex shader has to invert a matrix.
+void ComputeNormalMatrices(const glm::mat4* models, glm::mat3* normalMatrices, size_t count);
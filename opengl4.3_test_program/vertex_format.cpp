@@ -0,0 +1,62 @@
+#include "vertex_format.h"
+#include "glm/packing.hpp"
+
+QuantizationBounds ComputeQuantizationBounds(const Vertex* vertices, GLuint count)
+{
+	glm::vec3 minBound(0.0f), maxBound(0.0f);
+	if (count > 0)
+		minBound = maxBound = vertices[0].Positon;
+	for (GLuint i = 1; i < count; i++)
+	{
+		minBound = glm::min(minBound, vertices[i].Positon);
+		maxBound = glm::max(maxBound, vertices[i].Positon);
+	}
+	QuantizationBounds bounds;
+	bounds.origin = glm::vec4(minBound, 0.0f);
+	bounds.extent = glm::vec4(glm::max(maxBound - minBound, glm::vec3(1e-6f)), 0.0f);
+	return bounds;
+}
+
+static PackedPosition PackPosition(glm::vec3 position, const QuantizationBounds& bounds, GLuint boundsIndex)
+{
+	glm::vec3 unorm = glm::clamp((position - glm::vec3(bounds.origin)) / glm::vec3(bounds.extent), 0.0f, 1.0f);
+	PackedPosition packed;
+	packed.positionXY = glm::packUnorm2x16(glm::vec2(unorm.x, unorm.y));
+	packed.positionZBounds = (glm::packUnorm2x16(glm::vec2(unorm.z, 0.0f)) & 0xFFFF) | (boundsIndex << 16);
+	return packed;
+}
+
+// folds the lower hemisphere over the diagonals so the whole sphere maps onto [-1, 1]^2
+static glm::vec2 OctahedralEncode(glm::vec3 n)
+{
+	n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+	glm::vec2 encoded(n.x, n.y);
+	if (n.z < 0.0f)
+	{
+		glm::vec2 signs(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+		encoded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signs;
+	}
+	return encoded;
+}
+
+void PackVertices(const Vertex* vertices, GLuint count, const QuantizationBounds& bounds, GLuint boundsIndex, PackedVertex* packed)
+{
+	for (GLuint i = 0; i < count; i++)
+	{
+		PackedPosition position = PackPosition(vertices[i].Positon, bounds, boundsIndex);
+		packed[i].positionXY = position.positionXY;
+		packed[i].positionZBounds = position.positionZBounds;
+		glm::vec3 normal = vertices[i].Normal;
+		if (glm::dot(normal, normal) > 0.0f)
+			packed[i].normal = glm::packSnorm2x16(OctahedralEncode(normal));
+		else
+			packed[i].normal = 0;
+		packed[i].texCoords = glm::packHalf2x16(vertices[i].TexCoords);
+	}
+}
+
+void PackPositions(const glm::vec3* positions, GLuint count, const QuantizationBounds& bounds, GLuint boundsIndex, PackedPosition* packed)
+{
+	for (GLuint i = 0; i < count; i++)
+		packed[i] = PackPosition(positions[i], bounds, boundsIndex);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <GL/glew.h>
+#include "glm/glm.hpp"
+#include "mesh.h"
+
+// Vertex as the GPU stores it, 16 bytes instead of 32, decoded by
+// UnpackPosition and UnpackNormal in shaders/vertex_format.glsl; keep in sync with it.
+struct PackedVertex
+{
+	// x and y as unorm16 within the range's bounds
+	GLuint positionXY;
+	// z as unorm16, the high half is the range's entry in the bounds table
+	GLuint positionZBounds;
+	// octahedral unit normal as two snorm16
+	GLuint normal;
+	// u and v as half floats
+	GLuint texCoords;
+};
+
+// the position of a PackedVertex alone, for the depth only stream
+struct PackedPosition
+{
+	GLuint positionXY;
+	GLuint positionZBounds;
+};
+
+// dequantization of one range's positions, position = origin + unorm * extent
+struct QuantizationBounds
+{
+	// vec4 so the table is laid out the same in std430
+	glm::vec4 origin;
+	glm::vec4 extent;
+};
+
+// the bounds entry is 16 bits of the packed position
+const GLuint MAX_QUANTIZATION_BOUNDS = 1 << 16;
+
+// the axis aligned box of the positions, flat axes get a nonzero extent
+QuantizationBounds ComputeQuantizationBounds(const Vertex* vertices, GLuint count);
+
+void PackVertices(const Vertex* vertices, GLuint count, const QuantizationBounds& bounds, GLuint boundsIndex, PackedVertex* packed);
+void PackPositions(const glm::vec3* positions, GLuint count, const QuantizationBounds& bounds, GLuint boundsIndex, PackedPosition* packed);
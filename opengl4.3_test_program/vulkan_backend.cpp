@@ -0,0 +1,814 @@
+#include "vulkan_backend.h"
+
+#ifdef RENDER_BACKEND_VULKAN
+#include "instance_culling.h"
+#include "command_lists.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+// std140 PassData of shaders/vulkan/depth_cube.vert and .frag
+struct PassData
+{
+	glm::mat4 faceMatrices[6];
+	glm::vec3 lightPos;
+	float farPlane;
+};
+
+RenderBackend* CreateVulkanBackend(CommandListBuilder* workers)
+{
+	VulkanBackend* backend = new VulkanBackend(workers);
+	if (!backend->Initialized())
+	{
+		delete backend;
+		return NULL;
+	}
+	return backend;
+}
+
+VulkanBackend::VulkanBackend(CommandListBuilder* workers)
+{
+	this->workers = workers;
+	instance = VK_NULL_HANDLE;
+	device = VK_NULL_HANDLE;
+	nextHandle = 1;
+	positions = bounds = indices = instances = NULL_RENDER_HANDLE;
+	initialized = CreateDevice() && CreatePipelines();
+}
+
+VulkanBackend::~VulkanBackend()
+{
+	if (device != VK_NULL_HANDLE)
+	{
+		vkDeviceWaitIdle(device);
+		for (map<RenderHandle, Buffer>::iterator i = buffers.begin(); i != buffers.end(); ++i)
+			DestroyBuffer(i->second);
+		map<RenderHandle, Image>* images[] = { &textures, &depthCubes };
+		for (int m = 0; m < 2; m++)
+			for (map<RenderHandle, Image>::iterator i = images[m]->begin(); i != images[m]->end(); ++i)
+			{
+				if (i->second.framebuffer != VK_NULL_HANDLE)
+					vkDestroyFramebuffer(device, i->second.framebuffer, NULL);
+				vkDestroyImageView(device, i->second.view, NULL);
+				vkDestroyImage(device, i->second.image, NULL);
+				vkFreeMemory(device, i->second.memory, NULL);
+			}
+		if (initialized)
+		{
+			DestroyBuffer(passBuffer);
+			for (int face = 0; face < 6; face++)
+			{
+				vkDestroyPipeline(device, pipelines[face][0], NULL);
+				vkDestroyPipeline(device, pipelines[face][1], NULL);
+			}
+			vkDestroyPipelineLayout(device, pipelineLayout, NULL);
+			vkDestroyDescriptorPool(device, descriptorPool, NULL);
+			vkDestroyDescriptorSetLayout(device, setLayout, NULL);
+			vkDestroyRenderPass(device, renderPass, NULL);
+		}
+		for (int face = 0; face < 6; face++)
+			vkDestroyCommandPool(device, recorders[face].pool, NULL);
+		vkDestroyFence(device, fence, NULL);
+		vkDestroyCommandPool(device, commandPool, NULL);
+		vkDestroyDevice(device, NULL);
+	}
+	if (instance != VK_NULL_HANDLE)
+		vkDestroyInstance(instance, NULL);
+}
+
+bool VulkanBackend::Initialized() const
+{
+	return initialized;
+}
+
+const char* VulkanBackend::Name() const
+{
+	return "Vulkan 1.1";
+}
+
+// picks the first device with a graphics queue and multiview, no surface needed
+bool VulkanBackend::CreateDevice()
+{
+	VkApplicationInfo application = {};
+	application.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	application.pApplicationName = "opengl4.3_test_program";
+	application.apiVersion = VK_API_VERSION_1_1;
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo = &application;
+	if (vkCreateInstance(&instanceInfo, NULL, &instance) != VK_SUCCESS)
+	{
+		cout << "ERROR::VULKAN::INSTANCE_CREATION_FAILED" << endl;
+		instance = VK_NULL_HANDLE;
+		return false;
+	}
+
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, NULL);
+	vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+	physicalDevice = VK_NULL_HANDLE;
+	for (uint32_t d = 0; d < deviceCount && physicalDevice == VK_NULL_HANDLE; d++)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(devices[d], &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_1)
+			continue;
+		VkPhysicalDeviceMultiviewFeatures multiview = {};
+		multiview.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &multiview;
+		vkGetPhysicalDeviceFeatures2(devices[d], &features);
+		if (!multiview.multiview)
+			continue;
+
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(devices[d], &familyCount, NULL);
+		vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(devices[d], &familyCount, families.data());
+		for (uint32_t f = 0; f < familyCount; f++)
+			if (families[f].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			{
+				physicalDevice = devices[d];
+				queueFamily = f;
+				cout << "vulkan device: " << properties.deviceName << endl;
+				break;
+			}
+	}
+	if (physicalDevice == VK_NULL_HANDLE)
+	{
+		cout << "ERROR::VULKAN::NO_MULTIVIEW_DEVICE" << endl;
+		return false;
+	}
+
+	float priority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &priority;
+	VkPhysicalDeviceMultiviewFeatures multiview = {};
+	multiview.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+	multiview.multiview = VK_TRUE;
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.pNext = &multiview;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	if (vkCreateDevice(physicalDevice, &deviceInfo, NULL, &device) != VK_SUCCESS)
+	{
+		cout << "ERROR::VULKAN::DEVICE_CREATION_FAILED" << endl;
+		device = VK_NULL_HANDLE;
+		return false;
+	}
+	vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+	vkCreateCommandPool(device, &poolInfo, NULL, &commandPool);
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	vkAllocateCommandBuffers(device, &allocateInfo, &commands);
+
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	vkCreateFence(device, &fenceInfo, NULL, &fence);
+
+	// command pools are externally synchronized, so every face recorded in parallel has its own
+	for (int face = 0; face < 6; face++)
+	{
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		vkCreateCommandPool(device, &poolInfo, NULL, &recorders[face].pool);
+		allocateInfo.commandPool = recorders[face].pool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		vkAllocateCommandBuffers(device, &allocateInfo, &recorders[face].commands);
+	}
+	return true;
+}
+
+// SPIR-V of shaders/vulkan/depth_cube.vert and .frag, see the shaders for how to build it
+bool VulkanBackend::CreatePipelines()
+{
+	VkShaderModule vertexShader = LoadShader("shaders/vulkan/depth_cube.vert.spv");
+	VkShaderModule fragmentShader = LoadShader("shaders/vulkan/depth_cube.frag.spv");
+	if (vertexShader == VK_NULL_HANDLE || fragmentShader == VK_NULL_HANDLE)
+	{
+		if (vertexShader != VK_NULL_HANDLE)
+			vkDestroyShaderModule(device, vertexShader, NULL);
+		if (fragmentShader != VK_NULL_HANDLE)
+			vkDestroyShaderModule(device, fragmentShader, NULL);
+		return false;
+	}
+
+	// one depth attachment with six layers, loaded so the faces a pass skips
+	// keep their depth, the faces it renders clear their layer themselves
+	VkAttachmentDescription depth = {};
+	depth.format = VK_FORMAT_D32_SFLOAT;
+	depth.samples = VK_SAMPLE_COUNT_1_BIT;
+	depth.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depth.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depth.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	depth.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	VkAttachmentReference depthReference = { 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	// a subpass per face whose view mask is just that face, so gl_ViewIndex
+	// is the face and no draw reaches a layer it was not listed for
+	VkSubpassDescription subpasses[6] = {};
+	uint32_t viewMasks[6];
+	VkSubpassDependency dependencies[12] = {};
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		subpasses[face].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpasses[face].pDepthStencilAttachment = &depthReference;
+		viewMasks[face] = 1 << face;
+		// the faces write disjoint layers, so they only order against the outside
+		VkSubpassDependency& before = dependencies[face * 2];
+		before.srcSubpass = VK_SUBPASS_EXTERNAL;
+		before.dstSubpass = face;
+		before.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		before.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		before.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		before.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		VkSubpassDependency& after = dependencies[face * 2 + 1];
+		after.srcSubpass = face;
+		after.dstSubpass = VK_SUBPASS_EXTERNAL;
+		after.srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		after.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		after.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		after.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	}
+	VkRenderPassMultiviewCreateInfo multiviewInfo = {};
+	multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+	multiviewInfo.subpassCount = 6;
+	multiviewInfo.pViewMasks = viewMasks;
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.pNext = &multiviewInfo;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depth;
+	renderPassInfo.subpassCount = 6;
+	renderPassInfo.pSubpasses = subpasses;
+	renderPassInfo.dependencyCount = 12;
+	renderPassInfo.pDependencies = dependencies;
+	vkCreateRenderPass(device, &renderPassInfo, NULL, &renderPass);
+
+	// the heap's position stream, pulled by gl_VertexIndex, the pass data and
+	// the positions' quantization bounds
+	VkDescriptorSetLayoutBinding bindings[3] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[2].binding = 2;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[2].descriptorCount = 1;
+	bindings[2].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = 3;
+	setLayoutInfo.pBindings = bindings;
+	vkCreateDescriptorSetLayout(device, &setLayoutInfo, NULL, &setLayout);
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	vkCreatePipelineLayout(device, &layoutInfo, NULL, &pipelineLayout);
+
+	VkDescriptorPoolSize poolSizes[2] = { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 }, { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 } };
+	VkDescriptorPoolCreateInfo descriptorPoolInfo = {};
+	descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolInfo.maxSets = 1;
+	descriptorPoolInfo.poolSizeCount = 2;
+	descriptorPoolInfo.pPoolSizes = poolSizes;
+	vkCreateDescriptorPool(device, &descriptorPoolInfo, NULL, &descriptorPool);
+	VkDescriptorSetAllocateInfo setInfo = {};
+	setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setInfo.descriptorPool = descriptorPool;
+	setInfo.descriptorSetCount = 1;
+	setInfo.pSetLayouts = &setLayout;
+	vkAllocateDescriptorSets(device, &setInfo, &descriptorSet);
+	passBuffer = MakeBuffer(sizeof(PassData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertexShader;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragmentShader;
+	stages[1].pName = "main";
+
+	// the instance model matrix in locations 3 to 6, as in the GL shaders
+	VkVertexInputBindingDescription instanceBinding = { 0, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE };
+	VkVertexInputAttributeDescription attributes[4];
+	for (uint32_t column = 0; column < 4; column++)
+	{
+		attributes[column].location = 3 + column;
+		attributes[column].binding = 0;
+		attributes[column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		attributes[column].offset = offsetof(InstanceData, model) + column * sizeof(glm::vec4);
+	}
+	VkPipelineVertexInputStateCreateInfo vertexInput = {};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = 1;
+	vertexInput.pVertexBindingDescriptions = &instanceBinding;
+	vertexInput.vertexAttributeDescriptionCount = 4;
+	vertexInput.pVertexAttributeDescriptions = attributes;
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+	// The viewport is not flipped, so the faces' texel rows follow clip y as
+	// in GL and the cube samples the same. Vulkan measures winding in y down
+	// framebuffer coordinates though, so GL's counter clockwise front faces
+	// appear clockwise.
+	VkPipelineRasterizationStateCreateInfo rasterization = {};
+	rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+	VkPipelineMultisampleStateCreateInfo multisample = {};
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+	VkPipelineColorBlendStateCreateInfo colorBlend = {};
+	colorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInput;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterization;
+	pipelineInfo.pMultisampleState = &multisample;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlend;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	VkCullModeFlags cullModes[2] = { VK_CULL_MODE_BACK_BIT, VK_CULL_MODE_NONE };
+	bool created = true;
+	// pipelines are bound to their subpass, so every face has its own pair
+	for (uint32_t face = 0; face < 6; face++)
+		for (int i = 0; i < 2; i++)
+		{
+			pipelineInfo.subpass = face;
+			rasterization.cullMode = cullModes[i];
+			if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &pipelines[face][i]) != VK_SUCCESS)
+			{
+				cout << "ERROR::VULKAN::PIPELINE_CREATION_FAILED" << endl;
+				pipelines[face][i] = VK_NULL_HANDLE;
+				created = false;
+			}
+		}
+	vkDestroyShaderModule(device, vertexShader, NULL);
+	vkDestroyShaderModule(device, fragmentShader, NULL);
+	return created;
+}
+
+uint32_t VulkanBackend::MemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+	VkPhysicalDeviceMemoryProperties memory;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory);
+	for (uint32_t i = 0; i < memory.memoryTypeCount; i++)
+		if ((typeBits & (1 << i)) && (memory.memoryTypes[i].propertyFlags & properties) == properties)
+			return i;
+	cout << "ERROR::VULKAN::NO_MEMORY_TYPE" << endl;
+	return 0;
+}
+
+// host visible and mapped for its lifetime, uploads are a memcpy
+VulkanBackend::Buffer VulkanBackend::MakeBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+{
+	Buffer buffer;
+	buffer.size = size;
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	vkCreateBuffer(device, &bufferInfo, NULL, &buffer.buffer);
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(device, buffer.buffer, &requirements);
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = MemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	vkAllocateMemory(device, &allocateInfo, NULL, &buffer.memory);
+	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkMapMemory(device, buffer.memory, 0, size, 0, &buffer.mapped);
+	return buffer;
+}
+
+void VulkanBackend::DestroyBuffer(Buffer& buffer)
+{
+	vkUnmapMemory(device, buffer.memory);
+	vkDestroyBuffer(device, buffer.buffer, NULL);
+	vkFreeMemory(device, buffer.memory, NULL);
+}
+
+VulkanBackend::Image VulkanBackend::MakeImage(VkFormat format, int width, int height, uint32_t layers, VkImageUsageFlags usage, VkImageAspectFlags aspect)
+{
+	Image image;
+	image.size = width;
+	image.framebuffer = VK_NULL_HANDLE;
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.flags = layers == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = format;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = layers;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = usage;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	vkCreateImage(device, &imageInfo, NULL, &image.image);
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(device, image.image, &requirements);
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = MemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkAllocateMemory(device, &allocateInfo, NULL, &image.memory);
+	vkBindImageMemory(device, image.image, image.memory, 0);
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image.image;
+	viewInfo.viewType = layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspect;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = layers;
+	vkCreateImageView(device, &viewInfo, NULL, &image.view);
+	return image;
+}
+
+VkShaderModule VulkanBackend::LoadShader(const char* path)
+{
+	ifstream file(path, ios::binary | ios::ate);
+	if (!file)
+	{
+		cout << "ERROR::VULKAN::SHADER_NOT_FOUND " << path << endl;
+		return VK_NULL_HANDLE;
+	}
+	vector<char> code((size_t)file.tellg());
+	file.seekg(0);
+	file.read(code.data(), code.size());
+
+	VkShaderModuleCreateInfo moduleInfo = {};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = (const uint32_t*)code.data();
+	VkShaderModule module;
+	if (vkCreateShaderModule(device, &moduleInfo, NULL, &module) != VK_SUCCESS)
+	{
+		cout << "ERROR::VULKAN::SHADER_MODULE_CREATION_FAILED " << path << endl;
+		return VK_NULL_HANDLE;
+	}
+	return module;
+}
+
+// the one primary command buffer, every submission waits for it to finish
+VkCommandBuffer VulkanBackend::BeginCommands()
+{
+	vkResetCommandBuffer(commands, 0);
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commands, &beginInfo);
+	return commands;
+}
+
+void VulkanBackend::SubmitCommands()
+{
+	vkEndCommandBuffer(commands);
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commands;
+	vkQueueSubmit(queue, 1, &submitInfo, fence);
+	vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(device, 1, &fence);
+}
+
+RenderHandle VulkanBackend::CreateBuffer(BufferUsage usage, size_t size, const void* data)
+{
+	VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	if (usage == BUFFER_INDEX)
+		usageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	else if (usage == BUFFER_UNIFORM)
+		usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	else if (usage == BUFFER_STORAGE)
+		usageFlags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	Buffer buffer = MakeBuffer(size, usageFlags);
+	if (data)
+		memcpy(buffer.mapped, data, size);
+	buffers[nextHandle] = buffer;
+	return nextHandle++;
+}
+
+// only safe between passes, every pass has finished when RenderDepthCube returns
+void VulkanBackend::UpdateBuffer(RenderHandle buffer, size_t offset, size_t size, const void* data)
+{
+	memcpy((char*)buffers[buffer].mapped + offset, data, size);
+}
+
+// a single level, nothing samples it with minification in this backend yet
+RenderHandle VulkanBackend::CreateTexture(int width, int height, const unsigned char* rgba)
+{
+	Image texture = MakeImage(VK_FORMAT_R8G8B8A8_UNORM, width, height, 1, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+	Buffer staging = MakeBuffer(width * height * 4, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	memcpy(staging.mapped, rgba, width * height * 4);
+
+	VkCommandBuffer commands = BeginCommands();
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = texture.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = width;
+	region.imageExtent.height = height;
+	region.imageExtent.depth = 1;
+	vkCmdCopyBufferToImage(commands, staging.buffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	SubmitCommands();
+	DestroyBuffer(staging);
+
+	textures[nextHandle] = texture;
+	return nextHandle++;
+}
+
+// a six layer depth image, viewed as an array so multiview renders each layer,
+// cleared to the far plane since the render pass loads the faces it skips
+RenderHandle VulkanBackend::CreateDepthCube(int size)
+{
+	Image cube = MakeImage(VK_FORMAT_D32_SFLOAT, size, size, 6,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+		VK_IMAGE_ASPECT_DEPTH_BIT);
+	VkCommandBuffer commands = BeginCommands();
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = cube.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 6;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	VkClearDepthStencilValue far = { 1.0f, 0 };
+	vkCmdClearDepthStencilImage(commands, cube.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &far, 1, &barrier.subresourceRange);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	SubmitCommands();
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &cube.view;
+	framebufferInfo.width = size;
+	framebufferInfo.height = size;
+	// multiview framebuffers have one layer, the views pick the image layers
+	framebufferInfo.layers = 1;
+	vkCreateFramebuffer(device, &framebufferInfo, NULL, &cube.framebuffer);
+
+	depthCubes[nextHandle] = cube;
+	return nextHandle++;
+}
+
+void VulkanBackend::SetGeometry(RenderHandle positions, RenderHandle bounds, RenderHandle indices, RenderHandle instances)
+{
+	this->positions = positions;
+	this->bounds = bounds;
+	this->indices = indices;
+	this->instances = instances;
+
+	VkDescriptorBufferInfo positionInfo = { buffers[positions].buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo passInfo = { passBuffer.buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo boundsInfo = { buffers[bounds].buffer, 0, VK_WHOLE_SIZE };
+	VkWriteDescriptorSet writes[3] = {};
+	writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[0].dstSet = descriptorSet;
+	writes[0].dstBinding = 0;
+	writes[0].descriptorCount = 1;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writes[0].pBufferInfo = &positionInfo;
+	writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[1].dstSet = descriptorSet;
+	writes[1].dstBinding = 1;
+	writes[1].descriptorCount = 1;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	writes[1].pBufferInfo = &passInfo;
+	writes[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[2].dstSet = descriptorSet;
+	writes[2].dstBinding = 2;
+	writes[2].descriptorCount = 1;
+	writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writes[2].pBufferInfo = &boundsInfo;
+	vkUpdateDescriptorSets(device, 3, writes, 0, NULL);
+}
+
+// Every face of the pass' faceMask is one job on the workers, recorded
+// from the face's own list into its own secondary command buffer. The
+// primary command buffer then steps through the six face subpasses and
+// executes the recorded ones.
+void VulkanBackend::RenderDepthCube(const DepthCubePass& pass, const vector<BackendDraw> faceDraws[6])
+{
+	Image& target = depthCubes[pass.target];
+	PassData passData;
+	for (int i = 0; i < 6; i++)
+		passData.faceMatrices[i] = pass.faceMatrices[i];
+	passData.lightPos = pass.lightPos;
+	passData.farPlane = pass.farPlane;
+	memcpy(passBuffer.mapped, &passData, sizeof(passData));
+
+	FaceJobs jobs;
+	jobs.backend = this;
+	jobs.target = &target;
+	jobs.faceDraws = faceDraws;
+	unsigned int jobCount = 0;
+	for (uint32_t face = 0; face < 6; face++)
+		if (pass.faceMask & (1 << face))
+			jobs.faces[jobCount++] = face;
+	workers->Run(jobCount, RecordFaceJob, &jobs);
+
+	VkCommandBuffer commands = BeginCommands();
+	VkRenderPassBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	beginInfo.renderPass = renderPass;
+	beginInfo.framebuffer = target.framebuffer;
+	beginInfo.renderArea.extent.width = target.size;
+	beginInfo.renderArea.extent.height = target.size;
+	vkCmdBeginRenderPass(commands, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		if (face > 0)
+			vkCmdNextSubpass(commands, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		if (pass.faceMask & (1 << face))
+			vkCmdExecuteCommands(commands, 1, &recorders[face].commands);
+	}
+	vkCmdEndRenderPass(commands);
+	SubmitCommands();
+}
+
+void VulkanBackend::RecordFaceJob(void* context, unsigned int job)
+{
+	FaceJobs* jobs = (FaceJobs*)context;
+	uint32_t face = jobs->faces[job];
+	jobs->backend->RecordFace(face, *jobs->target, jobs->faceDraws[face]);
+}
+
+// runs on a worker thread, touching only the face's own pool
+void VulkanBackend::RecordFace(uint32_t face, const Image& target, const vector<BackendDraw>& draws)
+{
+	Recorder& recorder = recorders[face];
+	vkResetCommandPool(device, recorder.pool, 0);
+	VkCommandBufferInheritanceInfo inheritance = {};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.renderPass = renderPass;
+	inheritance.subpass = face;
+	inheritance.framebuffer = target.framebuffer;
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+	vkBeginCommandBuffer(recorder.commands, &beginInfo);
+
+	// dynamic state is not inherited, every secondary sets its own
+	VkViewport viewport = { 0.0f, 0.0f, (float)target.size, (float)target.size, 0.0f, 1.0f };
+	VkRect2D scissor = { { 0, 0 }, { (uint32_t)target.size, (uint32_t)target.size } };
+	vkCmdSetViewport(recorder.commands, 0, 1, &viewport);
+	vkCmdSetScissor(recorder.commands, 0, 1, &scissor);
+	// the render pass loads the layer, with the subpass' view mask this clears only the face
+	VkClearAttachment clear = {};
+	clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	clear.clearValue.depthStencil.depth = 1.0f;
+	VkClearRect clearRect = { scissor, 0, 1 };
+	vkCmdClearAttachments(recorder.commands, 1, &clear, 1, &clearRect);
+	vkCmdBindDescriptorSets(recorder.commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(recorder.commands, 0, 1, &buffers.at(instances).buffer, &offset);
+	// GeometryIndex
+	vkCmdBindIndexBuffer(recorder.commands, buffers.at(indices).buffer, 0, VK_INDEX_TYPE_UINT16);
+	int bound = -1;
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		const BackendDraw& draw = draws[i];
+		int pipeline = draw.twoSided ? 1 : 0;
+		if (pipeline != bound)
+		{
+			vkCmdBindPipeline(recorder.commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[face][pipeline]);
+			bound = pipeline;
+		}
+		vkCmdDrawIndexed(recorder.commands, draw.indexCount, draw.instanceCount, draw.firstIndex, draw.baseVertex, draw.firstInstance);
+	}
+	vkEndCommandBuffer(recorder.commands);
+}
+
+void VulkanBackend::ReadDepthFace(RenderHandle cube, int face, vector<float>& depths)
+{
+	Image& target = depthCubes[cube];
+	VkDeviceSize size = (VkDeviceSize)target.size * target.size * sizeof(float);
+	Buffer staging = MakeBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+	VkCommandBuffer commands = BeginCommands();
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = target.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = face;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	region.imageSubresource.baseArrayLayer = face;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = target.size;
+	region.imageExtent.height = target.size;
+	region.imageExtent.depth = 1;
+	vkCmdCopyImageToBuffer(commands, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging.buffer, 1, &region);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+	SubmitCommands();
+
+	depths.resize(target.size * target.size);
+	memcpy(depths.data(), staging.mapped, size);
+	DestroyBuffer(staging);
+}
+
+#else
+
+RenderBackend* CreateVulkanBackend(CommandListBuilder* /*workers*/)
+{
+	return NULL;
+}
+
+#endif
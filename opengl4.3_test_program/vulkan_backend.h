@@ -0,0 +1,106 @@
+#pragma once
+#include "render_backend.h"
+
+// Only built with RENDER_BACKEND_VULKAN defined and the Vulkan SDK on the
+// include and library paths, as the DebugVulkan configuration does, otherwise
+// CreateVulkanBackend returns NULL.
+#ifdef RENDER_BACKEND_VULKAN
+#include <vector>
+#include <map>
+#include <vulkan/vulkan.h>
+
+using namespace std;
+
+// RenderBackend over Vulkan 1.1 without a surface, so it runs on software
+// implementations such as lavapipe. The depth cube is one six layer image
+// rendered in a single render pass with a multiview subpass per face, whose
+// view mask selects the face's layer, so each face only draws its own list.
+// The faces are recorded into secondary command buffers as jobs of the
+// CommandListBuilder's workers, each face with its own command pool. All
+// memory is host visible and every pass waits for its fence, which keeps it
+// simple rather than fast.
+class VulkanBackend : public RenderBackend
+{
+public:
+	VulkanBackend(CommandListBuilder* workers);
+	~VulkanBackend();
+	// false when no device with Vulkan 1.1 multiview was found
+	bool Initialized() const;
+	const char* Name() const;
+	RenderHandle CreateBuffer(BufferUsage usage, size_t size, const void* data);
+	void UpdateBuffer(RenderHandle buffer, size_t offset, size_t size, const void* data);
+	RenderHandle CreateTexture(int width, int height, const unsigned char* rgba);
+	RenderHandle CreateDepthCube(int size);
+	void SetGeometry(RenderHandle positions, RenderHandle bounds, RenderHandle indices, RenderHandle instances);
+	void RenderDepthCube(const DepthCubePass& pass, const vector<BackendDraw> faceDraws[6]);
+	void ReadDepthFace(RenderHandle cube, int face, vector<float>& depths);
+private:
+	struct Buffer
+	{
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		void* mapped;
+		VkDeviceSize size;
+	};
+	struct Image
+	{
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+		int size;
+		VkFramebuffer framebuffer;
+	};
+	// a face's pool and the secondary command buffer it is recorded into
+	struct Recorder
+	{
+		VkCommandPool pool;
+		VkCommandBuffer commands;
+	};
+	// what the face recording jobs of one pass share
+	struct FaceJobs
+	{
+		VulkanBackend* backend;
+		const Image* target;
+		const vector<BackendDraw>* faceDraws;
+		uint32_t faces[6];
+	};
+
+	bool CreateDevice();
+	bool CreatePipelines();
+	uint32_t MemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+	Buffer MakeBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+	void DestroyBuffer(Buffer& buffer);
+	Image MakeImage(VkFormat format, int width, int height, uint32_t layers, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+	VkShaderModule LoadShader(const char* path);
+	VkCommandBuffer BeginCommands();
+	void SubmitCommands();
+	static void RecordFaceJob(void* context, unsigned int job);
+	void RecordFace(uint32_t face, const Image& target, const vector<BackendDraw>& draws);
+
+	bool initialized;
+	VkInstance instance;
+	VkPhysicalDevice physicalDevice;
+	VkDevice device;
+	uint32_t queueFamily;
+	VkQueue queue;
+	VkCommandPool commandPool;
+	VkCommandBuffer commands;
+	VkFence fence;
+	VkRenderPass renderPass;
+	VkDescriptorSetLayout setLayout;
+	VkPipelineLayout pipelineLayout;
+	// per face subpass, back face culled and two sided
+	VkPipeline pipelines[6][2];
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSet descriptorSet;
+	Buffer passBuffer;
+	CommandListBuilder* workers;
+	Recorder recorders[6];
+
+	RenderHandle nextHandle;
+	map<RenderHandle, Buffer> buffers;
+	map<RenderHandle, Image> textures;
+	map<RenderHandle, Image> depthCubes;
+	RenderHandle positions, bounds, indices, instances;
+};
+#endif
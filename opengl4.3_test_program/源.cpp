@@ -2,35 +2,185 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "stb_image.h"
+#include "gl_state.h"
 #include <iostream>
+#include <cfloat>
 #include "shader.h"
 #include "model.h"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "camera.h"
+#include "shadow_binning.h"
+#include "shadow_raster.h"
+#include "raytraced_shadows.h"
+#include "shadow_volumes.h"
+#include "lightmap_baker.h"
+#include "shadow_face_culling.h"
+#include "stream_buffer.h"
+#include "instance_culling.h"
+#include "render_queue.h"
+#include "geometry_heap.h"
+#include "static_batching.h"
+#include "material_table.h"
+#include "command_lists.h"
+#include "frame_packet.h"
+#include "transform_stage.h"
+#include "gl_backend.h"
+#include "primitives.h"
+#include "mesh_optimizer.h"
+#include "vulkan_backend.h"
 
 using namespace std;
 
-float deltaTime = 0.0f;
 float lastTime = 0.0f;
+// movement keys held down, the camera moves by each input step's own time
+bool keysHeld[GLFW_KEY_LAST + 1];
 float lastX = 400, lastY = 300;
 bool firstMouse = true;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+Camera overviewCamera(glm::vec3(0.0f, 3.5f, 4.5f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -35.0f);
+// main thread input state, published to the render thread every step
+FramePacket input;
+// the main thread publishes at least this often while waiting for events
+const double INPUT_STEP = 1.0 / 120.0;
 glm::vec3 lightPos(0.0f, 0.0f, 0.0f);
 int width, height;
 const GLuint SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
+// render thread state, copied from every frame packet; input changes the packet
+bool useShadowBinning = true;
+bool useRayTracedShadows = false;
+bool useShadowVolumes = false;
+bool useBakedShadows = false;
+bool useMultiView = false;
+bool useFaceCulling = true;
+bool useInstanceStress = false;
+bool useGpuDriven = false;
+bool useStaticBatching = true;
+bool useCommandLists = true;
+// chosen at startup when ARB_bindless_texture is available
+bool useBindlessTextures = false;
+const GLuint STRESS_GRID_SIZE = 32;
+const GLuint LIGHTMAP_TILE_SIZE = 128;
 
+// keep in sync with point_shadows.frag
+enum Shadow_Mode {
+	SHADOW_CUBE_MAP,
+	SHADOW_RAY_TRACED,
+	SHADOW_UNLIT,
+	SHADOW_LIT,
+	SHADOW_BAKED
+};
+
+struct SceneObject
+{
+	glm::mat4 model;
+	PrimitiveType primitive;
+	bool reverse_normals;
+	bool isStatic;
+	int lightmapTile;
+};
+vector<SceneObject> sceneObjects;
+
+// a mesh of its own in the heap, such as a model's, drawn as a batch of one instance
+struct SceneMesh
+{
+	Mesh* mesh;
+	glm::mat4 model;
+	bool isStatic;
+	GeometryRange geometry;
+	// object space bounding sphere, xyz center and w radius
+	glm::vec4 bounds;
+};
+vector<SceneMesh> sceneMeshes;
+// tessellation and placement of a sphere finer than the shadow texels
+// around it, so the binning path has a caster for the compute rasterizer
+const GLuint DENSE_SPHERE_SEGMENTS = 256, DENSE_SPHERE_RINGS = 128;
+const glm::vec3 DENSE_SPHERE_POSITION(2.5f, -1.0f, -2.5f);
+
+vector<InstanceBatch> instanceBatches;
+RenderQueue renderQueue;
+// distance quantized into the render queue depth bits
+const GLfloat RENDER_QUEUE_DEPTH_RANGE = 100.0f;
+// capacity of the geometry heap shared by every mesh
+const GLuint GEOMETRY_HEAP_VERTICES = 1 << 18, GEOMETRY_HEAP_INDICES = 1 << 20;
+GeometryHeap* geometryHeap = NULL;
+// indexed primitives every scene object is an instance of
+PrimitiveLibrary* primitives = NULL;
+// pre-transformed static objects, drawn in place of their instances when static batching is on
+vector<StaticBatch> staticBatches;
+// material 0 is the scene's default diffuse texture
+MaterialTable* materialTable = NULL;
+// resources and the cube depth pass go through the backend, the GL only
+// shadow techniques use its GL names directly
+GLBackend* glBackend = NULL;
+
+struct View
+{
+	// the matrices are filled in once the view's rectangle is final
+	View(Camera* camera, GLint x, GLint y, GLsizei width, GLsizei height)
+		: camera(camera), x(x), y(y), width(width), height(height), projection(1.0f), view(1.0f)
+	{
+	}
+	Camera* camera;
+	GLint x, y;
+	GLsizei width, height;
+	glm::mat4 projection;
+	glm::mat4 view;
+};
+
+// std140 uniform blocks shared by every shader, keep in sync with the shaders
+const GLuint FRAME_DATA_BINDING = 0, LIGHT_DATA_BINDING = 1, DRAW_DATA_BINDING = 2;
+struct FrameData
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec3 viewPos;
+	GLfloat padding;
+};
+struct LightData
+{
+	glm::mat4 shadowMatrices[6];
+	glm::vec3 lightPos;
+	GLfloat far_plane;
+};
+// per draw data, bound as its own range for every draw that needs it
+struct DrawData
+{
+	GLint face;
+	GLint padding[3];
+};
+
+void RenderLoop(GLFWwindow* window, FramePacketExchange* exchange);
+void ReportStats();
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
-unsigned int loadTexture(char const * path);
+RenderHandle loadTexture(RenderBackend& backend, char const * path);
+int RunVulkanDepthTest();
 
-void RenderCube();
-void RenderScene(Shader &shader);
+vector<glm::mat4> ShadowMatrices(const glm::vec3& position, GLfloat aspect, GLfloat near, GLfloat far);
+void BuildScene();
+SceneMesh MakeSceneMesh(Mesh& mesh, const glm::mat4& model, bool isStatic);
+void CollectShadowCasters(ShadowCasters& casters);
+void BakeStaticLighting(LightmapBaker& baker);
+void BuildStaticBatches(GeometryHeap& heap, const LightmapBaker& baker);
+void AddStressObjects(vector<SceneObject>& objects);
+void UploadInstances(InstanceCuller& culler);
+GLuint InstanceVAO();
+void RenderInstancesCulled(InstanceCuller& culler, GLuint firstBatch, GLuint batchCount);
+void ToBackendDraws(const RenderQueue& list, vector<BackendDraw>& draws);
+PassDesc ScenePass(Shader& shader, Shader* reverseShader, const glm::vec3& eye, const glm::mat4& viewProjection, bool cull, bool dynamicOnly, bool depthOnly);
+void BuildScenePass(const PassDesc& pass, RenderQueue& list);
+void RenderScene(Shader &shader, const glm::vec3& eye, bool dynamicOnly = false, Shader* reverseShader = NULL, bool depthOnly = false);
+void RenderSceneCulled(Shader &shader, InstanceCuller& culler, const glm::mat4& viewProjection, bool dynamicOnly = false, Shader* reverseShader = NULL, bool depthOnly = false);
 
-int main()
+int main(int argc, char* argv[])
 {
+	// renders the scene's depth cube through the Vulkan backend without a window or GPU
+	if (argc > 1 && string(argv[1]) == "--vulkan-depth-test")
+		return RunVulkanDepthTest();
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -43,114 +193,454 @@ int main()
 		glfwTerminate();
 		return -1;
 	}
+
+	glfwGetFramebufferSize(window, &width, &height);
+	glfwSetKeyCallback(window, key_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	input.useShadowBinning = useShadowBinning;
+	input.useRayTracedShadows = useRayTracedShadows;
+	input.useShadowVolumes = useShadowVolumes;
+	input.useBakedShadows = useBakedShadows;
+	input.useMultiView = useMultiView;
+	input.useFaceCulling = useFaceCulling;
+	input.useInstanceStress = useInstanceStress;
+	input.useGpuDriven = useGpuDriven;
+	input.useStaticBatching = useStaticBatching;
+	input.useCommandLists = useCommandLists;
+	input.instancesDirty = true;
+	input.reportStats = false;
+	input.camera = camera;
+	input.overviewCamera = overviewCamera;
+
+	// the render thread owns the GL context, this thread only handles
+	// events and input so neither can stall the other
+	FramePacketExchange exchange(input);
+	input.instancesDirty = false;
+	thread renderThread(RenderLoop, window, &exchange);
+	lastTime = glfwGetTime();
+	while (!glfwWindowShouldClose(window))
+	{
+		glfwWaitEventsTimeout(INPUT_STEP);
+
+		float currentTime = glfwGetTime();
+		float inputStep = currentTime - lastTime;
+		lastTime = currentTime;
+		if (keysHeld[GLFW_KEY_W])
+			camera.ProcessKeyboard(FORWARD, inputStep);
+		if (keysHeld[GLFW_KEY_S])
+			camera.ProcessKeyboard(BACKWARD, inputStep);
+		if (keysHeld[GLFW_KEY_A])
+			camera.ProcessKeyboard(LEFT, inputStep);
+		if (keysHeld[GLFW_KEY_D])
+			camera.ProcessKeyboard(RIGHT, inputStep);
+
+		input.camera = camera;
+		input.overviewCamera = overviewCamera;
+		exchange.Publish(input);
+		input.instancesDirty = false;
+		input.reportStats = false;
+	}
+	exchange.Stop();
+	renderThread.join();
+
+	glfwTerminate();
+	return 0;
+}
+
+void RenderLoop(GLFWwindow* window, FramePacketExchange* exchange)
+{
 	glfwMakeContextCurrent(window);
 
-	glEnable(GL_MULTISAMPLE);
+	GLState::Enable(GL_MULTISAMPLE);
 	glewExperimental = GL_TRUE;
 	if (glewInit() != GLEW_OK)
 	{
 		std::cout << "Failed to initialize GLEW" << std::endl;
-		return -1;
+		glfwSetWindowShouldClose(window, GL_TRUE);
+		return;
 	}
-
-	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
-	glfwSetKeyCallback(window, key_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	GLState::Enable(GL_DEPTH_TEST);
+	GLState::Enable(GL_CULL_FACE);
 
-	Shader ShadowRender_shader("shaders/point_shadows.vs", "shaders/point_shadows.frag");
+	useBindlessTextures = MaterialTable::Supported();
+	cout << "bindless textures: " << (useBindlessTextures ? "on" : "unsupported") << endl;
+	vector<string> renderDefines;
+	if (useBindlessTextures)
+		renderDefines.push_back("BINDLESS_TEXTURES");
+	Shader ShadowRender_shader("shaders/point_shadows.vs", "shaders/point_shadows.frag", renderDefines);
+	// the room is lit from inside, its variant flips normals at compile time
+	renderDefines.push_back("REVERSE_NORMALS");
+	Shader ShadowRenderReverse_shader("shaders/point_shadows.vs", "shaders/point_shadows.frag", renderDefines);
 	Shader DepthMapGen_shader("shaders/point_shadows_depth.vs", "shaders/point_shadows_depth.gs", "shaders/point_shadows_depth.frag");
+	Shader DepthFaceGen_shader("shaders/point_shadows_depth_face.vs", "shaders/point_shadows_depth.frag");
+	Shader DepthFaceInstanced_shader("shaders/point_shadows_depth_face_instanced.vs", "shaders/point_shadows_depth.frag");
+	Shader DepthPrepass_shader("shaders/point_shadows.vs", "shaders/depth_prepass.frag");
+
+	Shader* renderShaders[] = { &ShadowRender_shader, &ShadowRenderReverse_shader };
+	for (int i = 0; i < 2; i++)
+	{
+		renderShaders[i]->SetInt("diffuseTexture", 0);
+		renderShaders[i]->SetInt("depthMap", 1);
+		renderShaders[i]->SetInt("shadowMask", 2);
+	}
 
-	ShadowRender_shader.Use();
-	glUniform1i(glGetUniformLocation(ShadowRender_shader.Program, "diffuseTexture"), 0);
-	glUniform1i(glGetUniformLocation(ShadowRender_shader.Program, "depthMap"), 1);
-
-	GLuint floorTexture = loadTexture("textures/wood.png");
-
-	//load and create depth Texture(cube map)
-	GLuint depthMapFBO;
-	glGenFramebuffers(1, &depthMapFBO);
-	GLuint depthCubeMap;
-	glGenTextures(1, &depthCubeMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
-	for (int i = 0; i < 6; i++)
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubeMap, 0);
-	glDrawBuffer(GL_NONE);
-	glReadBuffer(GL_NONE);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		cout << "Framebuffer not complete!" << endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	// uniform blocks, per draw data and culling commands of a frame
+	StreamBuffer streamBuffer(65536);
+	GLBackend backend(streamBuffer);
+	glBackend = &backend;
+	cout << "render backend: " << backend.Name() << endl;
+
+	GLuint floorTexture = loadTexture(backend, "textures/wood.png");
+	MaterialTable materials;
+	materialTable = &materials;
+	if (useBindlessTextures)
+		materials.Add(floorTexture);
+
+	// depth cube map, a layered framebuffer for the geometry shader passes
+	// and one framebuffer per face for the per face passes
+	GLuint depthCubeMap = backend.CreateDepthCube(SHADOW_WIDTH);
+	GLuint depthMapFBO = backend.LayeredFramebuffer(depthCubeMap);
+	GLuint depthFaceFBO[6];
+	for (GLuint i = 0; i < 6; i++)
+		depthFaceFBO[i] = backend.FaceFramebuffer(depthCubeMap, i);
+
+	// every mesh's vertices and indices, pulled by the scene shaders
+	GeometryHeap sceneGeometry(GEOMETRY_HEAP_VERTICES, GEOMETRY_HEAP_INDICES);
+	geometryHeap = &sceneGeometry;
+	PrimitiveLibrary primitiveLibrary(sceneGeometry);
+	primitives = &primitiveLibrary;
+
+	BuildScene();
+	PrimitiveMesh denseSphere = MakeSphere(DENSE_SPHERE_SEGMENTS, DENSE_SPHERE_RINGS);
+	MeshStats generated, optimized;
+	OptimizeMesh(denseSphere.vertices, denseSphere.indices, generated, optimized);
+	Mesh denseMesh(denseSphere.vertices, denseSphere.indices, vector<Texture>(), sceneGeometry);
+	sceneMeshes.push_back(MakeSceneMesh(denseMesh, glm::scale(glm::translate(glm::mat4(1.0f), DENSE_SPHERE_POSITION), glm::vec3(0.5f)), false));
+	ShadowCasters shadowCasters;
+	CollectShadowCasters(shadowCasters);
+	shadowCasters.Upload();
+	ShadowBinner shadowBinner(shadowCasters);
+	ShadowRasterizer shadowRasterizer(shadowCasters, SHADOW_WIDTH, SHADOW_HEIGHT);
+	RayTracedShadows rayTracedShadows(shadowCasters.positions, width, height);
+	ShadowVolumes shadowVolumes(shadowCasters);
+
+	LightmapBaker lightmapBaker(LIGHTMAP_TILE_SIZE);
+	BakeStaticLighting(lightmapBaker);
+	BuildStaticBatches(sceneGeometry, lightmapBaker);
+	for (int i = 0; i < 2; i++)
+	{
+		renderShaders[i]->SetInt("lightmap", 3);
+		renderShaders[i]->SetInt("lightmapTilesPerRow", lightmapBaker.tilesPerRow);
+		renderShaders[i]->SetFloat("lightmapTileSize", (float)lightmapBaker.tileSize);
+	}
+
+	InstanceCuller instanceCuller(streamBuffer);
+	// the main thread builds lists too, so leave it one core
+	CommandListBuilder commandLists(glm::max(thread::hardware_concurrency(), 2u) - 1);
+	cout << "command lists: built on " << commandLists.workerCount + 1 << " threads" << endl;
 
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-	while (!glfwWindowShouldClose(window))
+	FramePacket frame;
+	while (exchange->Acquire(frame))
 	{
-		float currentTime = glfwGetTime();
-		deltaTime = currentTime - lastTime;
-		lastTime = currentTime;
+		useShadowBinning = frame.useShadowBinning;
+		useRayTracedShadows = frame.useRayTracedShadows;
+		useShadowVolumes = frame.useShadowVolumes;
+		useBakedShadows = frame.useBakedShadows;
+		useMultiView = frame.useMultiView;
+		useFaceCulling = frame.useFaceCulling;
+		useInstanceStress = frame.useInstanceStress;
+		useGpuDriven = frame.useGpuDriven;
+		useStaticBatching = frame.useStaticBatching;
+		useCommandLists = frame.useCommandLists;
+		// the stress grid only exists as instances, the caster soup behind the
+		// binning, ray traced and volume paths and the face culling lacks it, so
+		// its shadows come from the instanced depth cube while it is on
+		if (useInstanceStress)
+		{
+			useShadowBinning = false;
+			useRayTracedShadows = false;
+			useShadowVolumes = false;
+		}
+		if (frame.reportStats)
+			ReportStats();
 
-		glfwPollEvents();
+		if (frame.instancesDirty)
+			UploadInstances(instanceCuller);
 
 		GLfloat aspect = (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT;
 		GLfloat near = 1.0f;
 		GLfloat far = 25.0f;
-		glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), aspect, near, far);
-		vector<glm::mat4> shadowMatrices;
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
-		shadowMatrices.push_back(shadowProj * glm::lookAt(lightPos, lightPos + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
-
-		// Generate DepthMap
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-		glClear(GL_DEPTH_BUFFER_BIT);
-		DepthMapGen_shader.Use();
+		vector<glm::mat4> shadowMatrices = ShadowMatrices(lightPos, aspect, near, far);
+
+		streamBuffer.BeginFrame();
+		LightData lightData;
 		for (GLuint i = 0; i < 6; ++i)
-			glUniformMatrix4fv(glGetUniformLocation(DepthMapGen_shader.Program, ("shadowMatrices[" + std::to_string(i) + "]").c_str()), 1, GL_FALSE, glm::value_ptr(shadowMatrices[i]));
-		glUniform1f(glGetUniformLocation(DepthMapGen_shader.Program, "far_plane"), far);
-		glUniform3fv(glGetUniformLocation(DepthMapGen_shader.Program, "lightPos"), 1, &lightPos[0]);
+			lightData.shadowMatrices[i] = shadowMatrices[i];
+		lightData.lightPos = lightPos;
+		lightData.far_plane = far;
+		streamBuffer.Bind(GL_UNIFORM_BUFFER, LIGHT_DATA_BINDING, &lightData, sizeof(lightData));
+
+		vector<View> views;
+		View mainView(&frame.camera, 0, 0, width, height);
+		if (useMultiView)
+		{
+			mainView.width = width / 2;
+			View overview(&frame.overviewCamera, width / 2, 0, width - width / 2, height);
+			views.push_back(mainView);
+			views.push_back(overview);
+		}
+		else
+			views.push_back(mainView);
+
+		// only render the cube faces some view can sample
+		bool cullFaces = useFaceCulling && !useInstanceStress;
+		GLuint faceMask = cullFaces ? 0 : ALL_SHADOW_FACES;
+		for (unsigned int v = 0; v < views.size(); v++)
+		{
+			views[v].projection = glm::perspective(glm::radians(views[v].camera->Zoom), (float)views[v].width / (float)views[v].height, 0.1f, 100.0f);
+			views[v].view = views[v].camera->GetViewMatrix();
+			if (cullFaces)
+				faceMask |= VisibleShadowFaces(shadowCasters, views[v].projection * views[v].view, shadowMatrices);
+		}
+
+		// passes drawn from the CPU side scene are culled and sorted on worker
+		// threads up front, below the GL thread only replays their lists
+		bool listDepthFaces = useCommandLists && !useRayTracedShadows && !useShadowVolumes && (useBakedShadows || (!useGpuDriven && !useShadowBinning));
+		bool listViews = useCommandLists && !useGpuDriven && !(useShadowVolumes && !useRayTracedShadows);
+		vector<PassDesc> passes;
+		int faceLists[6];
+		vector<int> viewLists(views.size(), -1);
+		for (GLuint i = 0; i < 6; ++i)
+		{
+			faceLists[i] = -1;
+			if (!listDepthFaces || (faceMask & (1 << i)) == 0)
+				continue;
+			faceLists[i] = passes.size();
+			// baked shadows hold the static casters, the cube only the dynamic ones
+			passes.push_back(ScenePass(DepthFaceInstanced_shader, NULL, lightPos, shadowMatrices[i], true, useBakedShadows, true));
+		}
+		for (unsigned int v = 0; v < views.size() && listViews; v++)
+		{
+			viewLists[v] = passes.size();
+			passes.push_back(ScenePass(ShadowRender_shader, &ShadowRenderReverse_shader, views[v].camera->Position, views[v].projection * views[v].view, true, false, false));
+		}
+		commandLists.Build(passes, BuildScenePass);
+
+		// Generate DepthMap, once per frame and shared by every view
+		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+		if (!useRayTracedShadows)
+		{
+			if (useShadowVolumes)
+			{
+				shadowVolumes.Extract(lightPos);
+			}
+			else if (listDepthFaces)
+			{
+				// the backend streams its own copy of the light data, identical to this frame's
+				DepthCubePass pass;
+				pass.target = depthCubeMap;
+				for (GLuint i = 0; i < 6; ++i)
+					pass.faceMatrices[i] = shadowMatrices[i];
+				pass.lightPos = lightPos;
+				pass.farPlane = far;
+				pass.faceMask = 0;
+				vector<BackendDraw> faceDraws[6];
+				for (GLuint i = 0; i < 6; ++i)
+				{
+					if (faceLists[i] < 0)
+						continue;
+					pass.faceMask |= 1 << i;
+					ToBackendDraws(commandLists.lists[faceLists[i]], faceDraws[i]);
+				}
+				backend.RenderDepthCube(pass, faceDraws);
+			}
+			else if (useBakedShadows)
+			{
+				// static casters are in the lightmap, only dynamic ones need the depth cube
+				glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+				glClear(GL_DEPTH_BUFFER_BIT);
+				DepthMapGen_shader.Use();
+				DepthMapGen_shader.SetInt("faceMask", faceMask);
+
+				RenderScene(DepthMapGen_shader, lightPos, true, NULL, true);
+			}
+			else if (useGpuDriven)
+			{
+				// each face culls the instances against its own frustum
+				for (GLuint i = 0; i < 6; ++i)
+				{
+					if ((faceMask & (1 << i)) == 0)
+						continue;
+					glBindFramebuffer(GL_FRAMEBUFFER, depthFaceFBO[i]);
+					glClear(GL_DEPTH_BUFFER_BIT);
+					DepthFaceInstanced_shader.Use();
+					DrawData drawData = {};
+					drawData.face = i;
+					streamBuffer.Bind(GL_UNIFORM_BUFFER, DRAW_DATA_BINDING, &drawData, sizeof(drawData));
+					RenderSceneCulled(DepthFaceInstanced_shader, instanceCuller, shadowMatrices[i], false, NULL, true);
+				}
+			}
+			else if (useShadowBinning)
+			{
+				shadowCasters.SelectRasterPaths(lightPos, near, SHADOW_WIDTH);
+				shadowBinner.Bin(shadowMatrices, faceMask);
+				if (shadowCasters.computeMeshCount > 0)
+					shadowRasterizer.Raster(shadowMatrices, faceMask, lightPos, far);
+
+				GLState::Disable(GL_CULL_FACE);
+				for (GLuint i = 0; i < 6; ++i)
+				{
+					if ((faceMask & (1 << i)) == 0)
+						continue;
+					glBindFramebuffer(GL_FRAMEBUFFER, depthFaceFBO[i]);
+					glClear(GL_DEPTH_BUFFER_BIT);
+					DepthFaceGen_shader.Use();
+					DrawData drawData = {};
+					drawData.face = i;
+					streamBuffer.Bind(GL_UNIFORM_BUFFER, DRAW_DATA_BINDING, &drawData, sizeof(drawData));
+					shadowBinner.DrawFace(i);
+					// merge compute rasterized micro triangles through the depth test
+					if (shadowCasters.computeMeshCount > 0)
+						shadowRasterizer.Resolve(i);
+				}
+				GLState::Enable(GL_CULL_FACE);
+			}
+			else
+			{
+				glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+				glClear(GL_DEPTH_BUFFER_BIT);
+				DepthMapGen_shader.Use();
+				DepthMapGen_shader.SetInt("faceMask", faceMask);
 
-		RenderScene(DepthMapGen_shader);
+				RenderScene(DepthMapGen_shader, lightPos, false, NULL, true);
+			}
+		}
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// Render Scene and shadow
 		glViewport(0, 0, width, height);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		ShadowRender_shader.Use();
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		glUniformMatrix4fv(glGetUniformLocation(ShadowRender_shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-		glUniformMatrix4fv(glGetUniformLocation(ShadowRender_shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-		glUniform3fv(glGetUniformLocation(ShadowRender_shader.Program, "lightPos"), 1, &lightPos[0]);
-		glUniform3fv(glGetUniformLocation(ShadowRender_shader.Program, "viewPos"), 1, &camera.Position[0]);
-		glUniform1f(glGetUniformLocation(ShadowRender_shader.Program, "far_plane"), far);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, floorTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
-
-		RenderScene(ShadowRender_shader);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		for (unsigned int v = 0; v < views.size(); v++)
+		{
+			View& currentView = views[v];
+			glm::mat4 projection = currentView.projection;
+			glm::mat4 view = currentView.view;
+			FrameData frameData;
+			frameData.projection = projection;
+			frameData.view = view;
+			frameData.viewPos = currentView.camera->Position;
+			streamBuffer.Bind(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, &frameData, sizeof(frameData));
 
+			if (useRayTracedShadows)
+			{
+				// ray traced shadows start from the visible surface, so every view traces its own
+				rayTracedShadows.BeginDepthPrepass(currentView.x, currentView.y, currentView.width, currentView.height);
+				DepthPrepass_shader.Use();
+				RenderScene(DepthPrepass_shader, currentView.camera->Position);
+
+				vector<glm::vec4> lights;
+				lights.push_back(glm::vec4(lightPos, far));
+				rayTracedShadows.Trace(projection, view, lights, currentView.x, currentView.y, currentView.width, currentView.height);
+			}
+
+			glViewport(currentView.x, currentView.y, currentView.width, currentView.height);
+			ShadowRender_shader.Use();
+			if (useBindlessTextures)
+				materials.Bind();
+			else
+			{
+				GLState::ActiveTexture(GL_TEXTURE0);
+				GLState::BindTexture(GL_TEXTURE_2D, floorTexture);
+			}
+			GLState::ActiveTexture(GL_TEXTURE1);
+			GLState::BindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+			GLState::ActiveTexture(GL_TEXTURE2);
+			GLState::BindTexture(GL_TEXTURE_2D_ARRAY, rayTracedShadows.shadowMask);
+			GLState::ActiveTexture(GL_TEXTURE3);
+			GLState::BindTexture(GL_TEXTURE_2D, lightmapBaker.lightmap);
+
+			if (useShadowVolumes && !useRayTracedShadows)
+			{
+				// ambient pass lays down depth
+				ShadowRender_shader.SetInt("shadowMode", SHADOW_UNLIT);
+				ShadowRenderReverse_shader.SetInt("shadowMode", SHADOW_UNLIT);
+				RenderScene(ShadowRender_shader, currentView.camera->Position, false, &ShadowRenderReverse_shader);
+
+				// z-fail: count volume faces behind the visible surface into stencil
+				GLState::Enable(GL_STENCIL_TEST);
+				glDepthMask(GL_FALSE);
+				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+				GLState::Disable(GL_CULL_FACE);
+				GLState::Enable(GL_DEPTH_CLAMP);
+				glStencilFunc(GL_ALWAYS, 0, 0xFF);
+				glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+				glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+				shadowVolumes.Draw();
+				GLState::Disable(GL_DEPTH_CLAMP);
+				GLState::Enable(GL_CULL_FACE);
+				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+				// relight the surface wherever no volume encloses it
+				glStencilFunc(GL_EQUAL, 0, 0xFF);
+				glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+				glDepthFunc(GL_EQUAL);
+				ShadowRender_shader.SetInt("shadowMode", SHADOW_LIT);
+				ShadowRenderReverse_shader.SetInt("shadowMode", SHADOW_LIT);
+				RenderScene(ShadowRender_shader, currentView.camera->Position, false, &ShadowRenderReverse_shader);
+				glDepthFunc(GL_LESS);
+				glDepthMask(GL_TRUE);
+				GLState::Disable(GL_STENCIL_TEST);
+			}
+			else
+			{
+				Shadow_Mode shadowMode = SHADOW_CUBE_MAP;
+				if (useRayTracedShadows)
+					shadowMode = SHADOW_RAY_TRACED;
+				else if (useBakedShadows)
+					shadowMode = SHADOW_BAKED;
+				ShadowRender_shader.SetInt("shadowMode", shadowMode);
+				ShadowRenderReverse_shader.SetInt("shadowMode", shadowMode);
+				if (useGpuDriven)
+					RenderSceneCulled(ShadowRender_shader, instanceCuller, projection * view, false, &ShadowRenderReverse_shader);
+				else if (viewLists[v] >= 0)
+				{
+					geometryHeap->Bind();
+					commandLists.lists[viewLists[v]].Submit();
+				}
+				else
+					RenderScene(ShadowRender_shader, currentView.camera->Position, false, &ShadowRenderReverse_shader);
+			}
+		}
+
+		streamBuffer.EndFrame();
 		glfwSwapBuffers(window);
 	}
+	glfwMakeContextCurrent(NULL);
+}
 
-	glfwTerminate();
-	return 0;
+// prints and resets the render thread's counters
+void ReportStats()
+{
+	cout << "uniform uploads: " << Shader::uniformUploads << ", elided: " << Shader::elidedUploads << endl;
+	cout << "render queue draws: " << RenderQueue::draws << ", program changes: " << RenderQueue::programChanges
+		<< ", texture changes: " << RenderQueue::textureChanges << ", VAO changes: " << RenderQueue::VAOChanges << endl;
+	cout << "gl state calls issued: " << GLState::issued << ", elided: " << GLState::elided << endl;
+	cout << "backend depth draws: " << GLBackend::draws << endl;
+	Shader::uniformUploads = 0;
+	Shader::elidedUploads = 0;
+	GLState::issued = 0;
+	GLState::elided = 0;
+	RenderQueue::draws = 0;
+	RenderQueue::programChanges = 0;
+	RenderQueue::textureChanges = 0;
+	RenderQueue::VAOChanges = 0;
+	GLBackend::draws = 0;
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
@@ -162,14 +652,62 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
-	if (key == GLFW_KEY_W)
-		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (key == GLFW_KEY_S)
-		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (key == GLFW_KEY_A)
-		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (key == GLFW_KEY_D)
-		camera.ProcessKeyboard(RIGHT, deltaTime);
+	if (key >= 0 && key <= GLFW_KEY_LAST && action != GLFW_REPEAT)
+		keysHeld[key] = action == GLFW_PRESS;
+	if (key == GLFW_KEY_B && action == GLFW_PRESS)
+	{
+		input.useShadowBinning = !input.useShadowBinning;
+		cout << "shadow binning: " << (input.useShadowBinning ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_R && action == GLFW_PRESS)
+	{
+		input.useRayTracedShadows = !input.useRayTracedShadows;
+		cout << "ray traced shadows: " << (input.useRayTracedShadows ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_V && action == GLFW_PRESS)
+	{
+		input.useShadowVolumes = !input.useShadowVolumes;
+		cout << "shadow volumes: " << (input.useShadowVolumes ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		input.useBakedShadows = !input.useBakedShadows;
+		cout << "baked shadows: " << (input.useBakedShadows ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_M && action == GLFW_PRESS)
+	{
+		input.useMultiView = !input.useMultiView;
+		cout << "split screen: " << (input.useMultiView ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_F && action == GLFW_PRESS)
+	{
+		input.useFaceCulling = !input.useFaceCulling;
+		cout << "shadow face culling: " << (input.useFaceCulling ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_N && action == GLFW_PRESS)
+	{
+		input.useInstanceStress = !input.useInstanceStress;
+		input.instancesDirty = true;
+		cout << "instance stress: " << (input.useInstanceStress ? "on, shadows from the instanced depth cube" : "off") << endl;
+	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS)
+	{
+		input.useCommandLists = !input.useCommandLists;
+		cout << "threaded command lists: " << (input.useCommandLists ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_K && action == GLFW_PRESS)
+	{
+		input.useStaticBatching = !input.useStaticBatching;
+		input.instancesDirty = true;
+		cout << "static batching: " << (input.useStaticBatching ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_G && action == GLFW_PRESS)
+	{
+		input.useGpuDriven = !input.useGpuDriven;
+		cout << "gpu driven rendering: " << (input.useGpuDriven ? "on" : "off") << endl;
+	}
+	if (key == GLFW_KEY_U && action == GLFW_PRESS)
+		input.reportStats = true;
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -189,145 +727,556 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	camera.ProcessMouseMovement(xoffset, yoffset, true);
 }
 
-unsigned int loadTexture(char const * path)
+RenderHandle loadTexture(RenderBackend& backend, char const * path)
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
+	RenderHandle texture = NULL_RENDER_HANDLE;
 	int width, height, nrComponents;
 	unsigned char *data = stbi_load(path, &width, &height, &nrComponents, STBI_rgb_alpha);
 	if (data)
+		texture = backend.CreateTexture(width, height, data);
+	else
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+	stbi_image_free(data);
+
+	return texture;
+}
+
+
+// view projections of the six cube faces, in GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order
+vector<glm::mat4> ShadowMatrices(const glm::vec3& position, GLfloat aspect, GLfloat near, GLfloat far)
+{
+	glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), aspect, near, far);
+	vector<glm::mat4> shadowMatrices;
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
+	shadowMatrices.push_back(shadowProj * glm::lookAt(position, position + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
+	return shadowMatrices;
+}
+
+void BuildScene()
+{
+	SceneObject object;
+	//a big room
+	object.model = glm::scale(glm::mat4(1.0f), glm::vec3(10.0));
+	object.primitive = PRIMITIVE_CUBE;
+	object.reverse_normals = true;
+	object.isStatic = true;
+	object.lightmapTile = -1;
+	sceneObjects.push_back(object);
+
+	object.reverse_normals = false;
+	object.model = glm::mat4(1.0);
+	object.model = glm::translate(object.model, glm::vec3(4.0f, -3.5f, 0.0));
+	sceneObjects.push_back(object);
+	object.model = glm::mat4(1.0);
+	object.model = glm::translate(object.model, glm::vec3(2.0f, 3.0f, 1.0));
+	object.model = glm::scale(object.model, glm::vec3(1.5));
+	sceneObjects.push_back(object);
+	object.model = glm::mat4(1.0);
+	object.model = glm::translate(object.model, glm::vec3(-3.0f, -1.0f, 0.0));
+	sceneObjects.push_back(object);
+	object.model = glm::mat4(1.0);
+	object.model = glm::translate(object.model, glm::vec3(-1.5f, 1.0f, 1.5));
+	sceneObjects.push_back(object);
+	object.model = glm::mat4(1.0);
+	object.model = glm::translate(object.model, glm::vec3(-1.5f, 2.0f, -3.0));
+	object.model = glm::rotate(object.model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
+	object.model = glm::scale(object.model, glm::vec3(1.5));
+	sceneObjects.push_back(object);
+}
+
+SceneMesh MakeSceneMesh(Mesh& mesh, const glm::mat4& model, bool isStatic)
+{
+	SceneMesh sceneMesh;
+	sceneMesh.mesh = &mesh;
+	sceneMesh.model = model;
+	sceneMesh.isStatic = isStatic;
+	sceneMesh.geometry.firstVertex = mesh.firstVertex;
+	sceneMesh.geometry.vertexCount = mesh.vertices.size();
+	sceneMesh.geometry.firstIndex = mesh.firstIndex;
+	sceneMesh.geometry.indexCount = mesh.indices.size();
+	sceneMesh.geometry.firstPosition = mesh.firstPosition;
+	sceneMesh.geometry.positionCount = mesh.positionCount;
+	sceneMesh.geometry.firstPositionIndex = mesh.firstPositionIndex;
+
+	glm::vec3 minBound(FLT_MAX), maxBound(-FLT_MAX);
+	for (unsigned int i = 0; i < mesh.vertices.size(); i++)
+	{
+		minBound = glm::min(minBound, mesh.vertices[i].Positon);
+		maxBound = glm::max(maxBound, mesh.vertices[i].Positon);
+	}
+	glm::vec3 center = (minBound + maxBound) * 0.5f;
+	GLfloat radius = 0.0f;
+	for (unsigned int i = 0; i < mesh.vertices.size(); i++)
+		radius = glm::max(radius, glm::length(mesh.vertices[i].Positon - center));
+	sceneMesh.bounds = glm::vec4(center, radius);
+	return sceneMesh;
+}
+
+// a grid of small dynamic primitives filling the room, to test instancing at scale
+void AddStressObjects(vector<SceneObject>& objects)
+{
+	// the plane is one sided, it would vanish from half the views
+	const PrimitiveType stressPrimitives[] = { PRIMITIVE_CUBE, PRIMITIVE_SPHERE, PRIMITIVE_CYLINDER, PRIMITIVE_CONE };
+	SceneObject object;
+	object.reverse_normals = false;
+	object.isStatic = false;
+	object.lightmapTile = -1;
+	GLfloat spacing = 9.0f / STRESS_GRID_SIZE;
+	for (GLuint x = 0; x < STRESS_GRID_SIZE; x++)
+		for (GLuint y = 0; y < STRESS_GRID_SIZE; y++)
+			for (GLuint z = 0; z < STRESS_GRID_SIZE; z++)
+			{
+				glm::vec3 position = glm::vec3(x, y, z) * spacing - glm::vec3(4.5f - spacing * 0.5f);
+				object.model = glm::translate(glm::mat4(1.0f), position);
+				object.model = glm::scale(object.model, glm::vec3(spacing * 0.3f));
+				object.primitive = stressPrimitives[(x + y + z) % 4];
+				objects.push_back(object);
+			}
+}
+
+// material table index of a batch texture, 0 stands for the scene's default texture
+GLint SceneMaterial(GLuint texture)
+{
+	if (!useBindlessTextures || texture == 0)
+		return 0;
+	return materialTable->Add(texture);
+}
+
+GLuint instanceVBO = 0;
+void UploadInstances(InstanceCuller& culler)
+{
+	vector<SceneObject> objects = sceneObjects;
+	if (useInstanceStress)
+		AddStressObjects(objects);
+
+	// group objects by render state so every group is one instanced draw
+	vector<InstanceData> instances;
+	vector<glm::mat4> models;
+	instanceBatches.clear();
+	for (int reverse = 1; reverse >= 0; reverse--)
+		for (int isStatic = 1; isStatic >= 0; isStatic--)
+		{
+			if (isStatic == 1 && useStaticBatching)
+			{
+				// one identity instance per pre-transformed batch
+				for (unsigned int i = 0; i < staticBatches.size(); i++)
+				{
+					if (staticBatches[i].material.reverse_normals != (reverse == 1))
+						continue;
+					InstanceBatch batch;
+					batch.first = instances.size();
+					batch.count = 1;
+					batch.reverse_normals = reverse == 1;
+					batch.isStatic = true;
+					batch.texture = staticBatches[i].material.texture;
+					batch.geometry = staticBatches[i].geometry;
+					batch.meshBounds = glm::vec4(staticBatches[i].center, staticBatches[i].radius);
+					batch.center = staticBatches[i].center;
+					batch.radius = staticBatches[i].radius;
+					instanceBatches.push_back(batch);
+
+					InstanceData instance;
+					instance.model = glm::mat4(1.0f);
+					instance.lightmapTile = -1;
+					instance.material = SceneMaterial(batch.texture);
+					instances.push_back(instance);
+					models.push_back(instance.model);
+				}
+				continue;
+			}
+
+			for (int primitive = 0; primitive < PRIMITIVE_COUNT; primitive++)
+			{
+				const PrimitiveMesh& mesh = primitives->meshes[primitive];
+				InstanceBatch batch;
+				batch.first = instances.size();
+				batch.count = 0;
+				batch.reverse_normals = reverse == 1;
+				batch.isStatic = isStatic == 1;
+				batch.texture = 0;
+				batch.geometry = primitives->ranges[primitive];
+				batch.meshBounds = glm::vec4(0.0f, 0.0f, 0.0f, mesh.radius);
+				glm::vec3 minBound(FLT_MAX), maxBound(-FLT_MAX);
+				GLfloat maxRadius = 0.0f;
+				for (unsigned int i = 0; i < objects.size(); i++)
+				{
+					if (objects[i].primitive != primitive || objects[i].reverse_normals != batch.reverse_normals || objects[i].isStatic != batch.isStatic)
+						continue;
+					InstanceData instance;
+					instance.model = objects[i].model;
+					instance.lightmapTile = objects[i].lightmapTile;
+					instance.material = SceneMaterial(batch.texture);
+					instances.push_back(instance);
+					models.push_back(objects[i].model);
+					batch.count++;
+
+					glm::vec3 position(objects[i].model[3]);
+					minBound = glm::min(minBound, position);
+					maxBound = glm::max(maxBound, position);
+					glm::mat3 basis(objects[i].model);
+					maxRadius = glm::max(maxRadius, mesh.radius * glm::max(glm::length(basis[0]), glm::max(glm::length(basis[1]), glm::length(basis[2]))));
+				}
+				batch.center = (minBound + maxBound) * 0.5f;
+				batch.radius = glm::length(maxBound - minBound) * 0.5f + maxRadius;
+				if (batch.count > 0)
+					instanceBatches.push_back(batch);
+			}
+
+			for (unsigned int i = 0; i < sceneMeshes.size(); i++)
+			{
+				const SceneMesh& sceneMesh = sceneMeshes[i];
+				if (reverse == 1 || sceneMesh.isStatic != (isStatic == 1))
+					continue;
+				InstanceBatch batch;
+				batch.first = instances.size();
+				batch.count = 1;
+				batch.reverse_normals = false;
+				batch.isStatic = sceneMesh.isStatic;
+				batch.texture = sceneMesh.mesh->textures.empty() ? 0 : sceneMesh.mesh->textures[0].id;
+				batch.geometry = sceneMesh.geometry;
+				batch.meshBounds = sceneMesh.bounds;
+				glm::mat3 basis(sceneMesh.model);
+				batch.center = glm::vec3(sceneMesh.model * glm::vec4(glm::vec3(sceneMesh.bounds), 1.0f));
+				batch.radius = sceneMesh.bounds.w * glm::max(glm::length(basis[0]), glm::max(glm::length(basis[1]), glm::length(basis[2])));
+				instanceBatches.push_back(batch);
+
+				InstanceData instance;
+				instance.model = sceneMesh.model;
+				instance.lightmapTile = -1;
+				instance.material = SceneMaterial(batch.texture);
+				instances.push_back(instance);
+				models.push_back(sceneMesh.model);
+			}
+		}
+
+	vector<glm::mat3> normalMatrices(models.size());
+	ComputeNormalMatrices(models.data(), normalMatrices.data(), models.size());
+	for (unsigned int i = 0; i < instances.size(); i++)
+		instances[i].normalMatrix = normalMatrices[i];
+
+	if (instanceVBO == 0)
+		glGenBuffers(1, &instanceVBO);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glBackend->SetGeometry(geometryHeap->positionBuffer, geometryHeap->boundsBuffer, geometryHeap->indexBuffer, instanceVBO);
+
+	culler.Setup(instanceVBO, instanceBatches);
+}
+
+// the VAO is looked up here because workers must not make GL calls
+PassDesc ScenePass(Shader& shader, Shader* reverseShader, const glm::vec3& eye, const glm::mat4& viewProjection, bool cull, bool dynamicOnly, bool depthOnly)
+{
+	PassDesc pass;
+	pass.viewProjection = viewProjection;
+	pass.eye = eye;
+	pass.cull = cull;
+	pass.dynamicOnly = dynamicOnly;
+	pass.depthOnly = depthOnly;
+	pass.shader = &shader;
+	pass.reverseShader = reverseShader;
+	pass.VAO = InstanceVAO();
+	return pass;
+}
+
+// fills a sorted list for one pass, only reads scene data so workers can run it
+void BuildScenePass(const PassDesc& pass, RenderQueue& list)
+{
+	for (unsigned int i = 0; i < instanceBatches.size(); i++)
 	{
+		const InstanceBatch& batch = instanceBatches[i];
+		if (pass.dynamicOnly && batch.isStatic)
+			continue;
+		if (pass.cull && !SphereInFrustum(pass.viewProjection, batch.center, batch.radius))
+			continue;
+		RenderItem item;
+		item.shader = batch.reverse_normals && pass.reverseShader ? pass.reverseShader : pass.shader;
+		// bindless draws fetch their texture per instance, so textures never split the queue
+		item.texture = useBindlessTextures ? 0 : batch.texture;
+		item.VAO = pass.VAO;
+		item.geometry = pass.depthOnly ? DepthGeometry(batch.geometry) : batch.geometry;
+		item.firstInstance = batch.first;
+		item.instanceCount = batch.count;
+		item.twoSided = batch.reverse_normals;
+		// the room encloses everything, drawing it last lets the cubes fill depth first
+		GLuint drawPass = item.twoSided ? 1 : 0;
+		GLfloat depth = glm::max(0.0f, glm::length(batch.center - pass.eye) - batch.radius);
+		item.key = RenderQueue::MakeKey(drawPass, item.shader->Program, item.texture, item.VAO, depth, RENDER_QUEUE_DEPTH_RANGE);
+		list.Push(item);
+	}
+}
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+void RenderScene(Shader &shader, const glm::vec3& eye, bool dynamicOnly, Shader* reverseShader, bool depthOnly)
+{
+	geometryHeap->Bind();
+	renderQueue.Clear();
+	BuildScenePass(ScenePass(shader, reverseShader, eye, glm::mat4(1.0f), false, dynamicOnly, depthOnly), renderQueue);
+	renderQueue.Sort();
+	renderQueue.Submit();
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+// Culls on the GPU, then draws every run of batches sharing render state
+// with one multi-draw. Batches are ordered reverse_normals first.
+void RenderSceneCulled(Shader &shader, InstanceCuller& culler, const glm::mat4& viewProjection, bool dynamicOnly, Shader* reverseShader, bool depthOnly)
+{
+	culler.Cull(viewProjection, dynamicOnly, depthOnly);
+	geometryHeap->Bind();
+	GLuint first = 0;
+	while (first < instanceBatches.size())
+	{
+		GLuint last = first;
+		while (last + 1 < instanceBatches.size() && instanceBatches[last + 1].reverse_normals == instanceBatches[first].reverse_normals)
+			last++;
+		if (instanceBatches[first].reverse_normals)
+		{
+			GLState::Disable(GL_CULL_FACE);
+			if (reverseShader)
+				reverseShader->Use();
+			RenderInstancesCulled(culler, first, last - first + 1);
+			GLState::Enable(GL_CULL_FACE);
+		}
+		else
+		{
+			shader.Use();
+			RenderInstancesCulled(culler, first, last - first + 1);
+		}
+		first = last + 1;
+	}
+}
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+void CollectShadowCasters(ShadowCasters& casters)
+{
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
+	{
+		const PrimitiveMesh& mesh = primitives->meshes[sceneObjects[i].primitive];
+		vector<glm::vec3> positions;
+		for (unsigned int v = 0; v < mesh.indices.size(); v++)
+			positions.push_back(glm::vec3(sceneObjects[i].model * glm::vec4(mesh.vertices[mesh.indices[v]].Positon, 1.0f)));
+		casters.AddTriangles(positions);
+	}
+	for (unsigned int i = 0; i < sceneMeshes.size(); i++)
+		casters.AddMesh(*sceneMeshes[i].mesh, sceneMeshes[i].model);
+}
 
-		stbi_image_free(data);
+void BakeStaticLighting(LightmapBaker& baker)
+{
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
+	{
+		if (!sceneObjects[i].isStatic)
+			continue;
+		// one chart per cube face, other primitives have no per face uvs to bake into
+		if (sceneObjects[i].primitive != PRIMITIVE_CUBE)
+		{
+			cout << "ERROR::LIGHTMAP::STATIC_OBJECT_NOT_A_CUBE " << i << endl;
+			continue;
+		}
+		const PrimitiveMesh& mesh = primitives->meshes[sceneObjects[i].primitive];
+		vector<glm::vec3> positions;
+		vector<glm::vec2> uvs;
+		vector<int> charts;
+		for (unsigned int v = 0; v < mesh.indices.size(); v++)
+		{
+			const Vertex& vertex = mesh.vertices[mesh.indices[v]];
+			positions.push_back(glm::vec3(sceneObjects[i].model * glm::vec4(vertex.Positon, 1.0f)));
+			uvs.push_back(vertex.TexCoords);
+			if (v % 3 == 0)
+				charts.push_back(CubeFace(vertex.Normal));
+		}
+		sceneObjects[i].lightmapTile = baker.AddStaticMesh(positions, uvs, charts, 6);
 	}
-	else
+	baker.Bake(lightPos, "lightmap.cache");
+}
+
+// merges every static scene object into pre-transformed batches per material
+void BuildStaticBatches(GeometryHeap& heap, const LightmapBaker& baker)
+{
+	StaticBatcher batcher;
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
 	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+		if (!sceneObjects[i].isStatic)
+			continue;
+		const vector<Vertex>& vertices = primitives->meshes[sceneObjects[i].primitive].vertices;
+		const vector<GLuint>& indices = primitives->meshes[sceneObjects[i].primitive].indices;
+		vector<glm::vec2> lightmapCoords;
+		if (sceneObjects[i].lightmapTile >= 0)
+		{
+			for (unsigned int v = 0; v < vertices.size(); v++)
+				lightmapCoords.push_back(baker.AtlasCoords(sceneObjects[i].lightmapTile + CubeFace(vertices[v].Normal), vertices[v].TexCoords));
+		}
+		StaticMaterial material = { 0, sceneObjects[i].reverse_normals };
+		batcher.Add(material, vertices, indices, sceneObjects[i].model, lightmapCoords);
+	}
+	// scene meshes are not baked, their first texture is the material
+	for (unsigned int i = 0; i < sceneMeshes.size(); i++)
+	{
+		if (sceneMeshes[i].isStatic)
+			batcher.AddMesh(*sceneMeshes[i].mesh, sceneMeshes[i].model, false);
 	}
+	batcher.Build(heap);
+	staticBatches = batcher.batches;
+	cout << "static batching: " << batcher.sourceCount << " static draws per pass merged into " << staticBatches.size() << endl;
+}
 
-	return textureID;
+// render queue items draw instance ranges of the instance buffer with base instance
+GLuint InstanceVAO()
+{
+	return glBackend->VertexInput(instanceVBO);
 }
 
+void RenderInstancesCulled(InstanceCuller& culler, GLuint firstBatch, GLuint batchCount)
+{
+	GLState::BindVertexArray(glBackend->VertexInput(culler.visibleBuffer));
+	culler.Draw(firstBatch, batchCount);
+}
 
-void RenderScene(Shader &shader)
+// a sorted list as backend draws, the backend picks its own depth pipeline
+void ToBackendDraws(const RenderQueue& list, vector<BackendDraw>& draws)
 {
-	//render a  big room
-	glm::mat4 model(1.0f);
-	model = glm::scale(model, glm::vec3(10.0));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	glDisable(GL_CULL_FACE);
-	// reverse normal to irradiate room(inside)
-	glUniform1i(glGetUniformLocation(shader.Program, "reverse_normals"), 1);
-	RenderCube();
-	glUniform1i(glGetUniformLocation(shader.Program, "reverse_normals"), 0);
-	glEnable(GL_CULL_FACE);
-	
-	model = glm::mat4(1.0);
-	model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	RenderCube();
-	model = glm::mat4(1.0);
-	model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
-	model = glm::scale(model, glm::vec3(1.5));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	RenderCube();
-	model = glm::mat4(1.0);
-	model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	RenderCube();
-	model = glm::mat4(1.0);
-	model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	RenderCube();
-	model = glm::mat4(1.0);
-	model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
-	model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-	model = glm::scale(model, glm::vec3(1.5));
-	glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-	RenderCube();
-	
+	for (GLuint i = 0; i < list.Size(); i++)
+	{
+		const RenderItem& item = list.Sorted(i);
+		BackendDraw draw;
+		draw.indexCount = item.geometry.indexCount;
+		draw.firstIndex = item.geometry.firstIndex;
+		draw.baseVertex = item.geometry.firstVertex;
+		draw.instanceCount = item.instanceCount;
+		draw.firstInstance = item.firstInstance;
+		draw.twoSided = item.twoSided;
+		draws.push_back(draw);
+	}
 }
 
-GLuint cubeVAO = 0;
-GLuint cubeVBO = 0;
-void RenderCube()
+// Renders the scene's depth cube through the Vulkan backend and prints how
+// much of each face the casters cover. It needs no window or GL context, so
+// it runs on lavapipe on machines without a GPU.
+int RunVulkanDepthTest()
 {
-	static GLfloat vertices[] = {
-		// Back face
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, // Bottom-left
-		0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, // top-right
-		0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
-		0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,  // top-right
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
-		-0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,// top-left
-		// Front face
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
-		0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,  // bottom-right
-		0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,  // top-right
-		0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, // top-right
-		-0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,  // top-left
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
-		// Left face
-		-0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
-		-0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-left
-		-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
-		-0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-left
-		-0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,  // bottom-right
-		-0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
-		// Right face
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-left
-		0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-right
-		0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-right         
-		0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-right
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // top-left
-		0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // bottom-left     
-		// Bottom face
-		-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
-		0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f, // top-left
-		0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,// bottom-left
-		0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, // bottom-left
-		-0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-right
-		-0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
-		// Top face
-		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
-		0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-		0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, // top-right     
-		0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
-		-0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f // bottom-left        
-	};
-	if (cubeVAO == 0) {
-		glGenVertexArrays(1, &cubeVAO);
-		glGenBuffers(1, &cubeVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-		glBindVertexArray(cubeVAO);
-
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	CommandListBuilder workers(glm::max(thread::hardware_concurrency(), 2u) - 1);
+	RenderBackend* vulkan = CreateVulkanBackend(&workers);
+	if (!vulkan)
+	{
+		cout << "ERROR::VULKAN::BACKEND_UNAVAILABLE" << endl;
+		return -1;
 	}
+	cout << "render backend: " << vulkan->Name() << endl;
 
-	glBindVertexArray(cubeVAO);
-	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	// the primitives' position streams back to back, packed as the geometry heap would hold them
+	vector<PackedPosition> positions;
+	vector<GeometryIndex> indices;
+	vector<QuantizationBounds> bounds;
+	GeometryRange ranges[PRIMITIVE_COUNT];
+	GLfloat radii[PRIMITIVE_COUNT];
+	for (int type = 0; type < PRIMITIVE_COUNT; type++)
+	{
+		PrimitiveMesh mesh = MakePrimitive((PrimitiveType)type);
+		radii[type] = mesh.radius;
+		MeshStats generated, optimized;
+		OptimizeMesh(mesh.vertices, mesh.indices, generated, optimized);
+		vector<glm::vec3> meshPositions;
+		vector<GLuint> positionIndices;
+		BuildPositionStream(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), meshPositions, positionIndices);
+		GeometryRange range = { 0, 0, 0, (GLuint)positionIndices.size(), (GLuint)positions.size(), (GLuint)meshPositions.size(), (GLuint)indices.size() };
+		ranges[type] = DepthGeometry(range);
+		bounds.push_back(ComputeQuantizationBounds(mesh.vertices.data(), mesh.vertices.size()));
+		positions.resize(range.firstPosition + range.positionCount);
+		PackPositions(meshPositions.data(), meshPositions.size(), bounds.back(), type, &positions[range.firstPosition]);
+		indices.insert(indices.end(), positionIndices.begin(), positionIndices.end());
+	}
+
+	BuildScene();
+	vector<glm::mat4> models;
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
+		models.push_back(sceneObjects[i].model);
+	vector<glm::mat3> normalMatrices(models.size());
+	ComputeNormalMatrices(models.data(), normalMatrices.data(), models.size());
+	vector<InstanceData> instances(sceneObjects.size());
+	vector<BackendDraw> draws;
+	vector<glm::vec4> spheres;
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
+	{
+		glm::mat3 basis(models[i]);
+		GLfloat scale = glm::max(glm::length(basis[0]), glm::max(glm::length(basis[1]), glm::length(basis[2])));
+		spheres.push_back(glm::vec4(glm::vec3(models[i][3]), radii[sceneObjects[i].primitive] * scale));
+		instances[i].model = models[i];
+		instances[i].normalMatrix = normalMatrices[i];
+		instances[i].lightmapTile = -1;
+		instances[i].material = 0;
+		const GeometryRange& range = ranges[sceneObjects[i].primitive];
+		BackendDraw draw = { range.indexCount, range.firstIndex, range.firstVertex, 1, i, sceneObjects[i].reverse_normals };
+		draws.push_back(draw);
+	}
+	RenderHandle positionBuffer = vulkan->CreateBuffer(BUFFER_STORAGE, positions.size() * sizeof(PackedPosition), positions.data());
+	RenderHandle boundsBuffer = vulkan->CreateBuffer(BUFFER_STORAGE, bounds.size() * sizeof(QuantizationBounds), bounds.data());
+	RenderHandle indexBuffer = vulkan->CreateBuffer(BUFFER_INDEX, indices.size() * sizeof(GeometryIndex), indices.data());
+	RenderHandle instanceBuffer = vulkan->CreateBuffer(BUFFER_INSTANCE, instances.size() * sizeof(InstanceData), instances.data());
+	vulkan->SetGeometry(positionBuffer, boundsBuffer, indexBuffer, instanceBuffer);
+
+	GLfloat far = 25.0f;
+	vector<glm::mat4> shadowMatrices = ShadowMatrices(lightPos, 1.0f, 1.0f, far);
+	DepthCubePass pass;
+	pass.target = vulkan->CreateDepthCube(SHADOW_WIDTH);
+	for (GLuint i = 0; i < 6; i++)
+		pass.faceMatrices[i] = shadowMatrices[i];
+	pass.lightPos = lightPos;
+	pass.farPlane = far;
+	pass.faceMask = ALL_SHADOW_FACES;
+	// every face gets only the objects in its frustum, as the command lists cull them
+	vector<BackendDraw> faceDraws[6];
+	for (GLuint i = 0; i < 6; i++)
+		for (unsigned int d = 0; d < draws.size(); d++)
+			if (SphereInFrustum(shadowMatrices[i], glm::vec3(spheres[d]), spheres[d].w))
+				faceDraws[i].push_back(draws[d]);
+	vulkan->RenderDepthCube(pass, faceDraws);
 
-}
\ No newline at end of file
+	// The room closes every face, so each texel must have been written. Every
+	// DEPTH_TEST_STRIDE-th texel must also agree with a ray cast through a BVH
+	// of the scene, with texel rows along clip y as GL lays out the faces.
+	vector<glm::vec4> trianglePositions;
+	for (unsigned int i = 0; i < sceneObjects.size(); i++)
+	{
+		PrimitiveMesh mesh = MakePrimitive(sceneObjects[i].primitive);
+		for (unsigned int v = 0; v < mesh.indices.size(); v++)
+			trianglePositions.push_back(models[i] * glm::vec4(mesh.vertices[mesh.indices[v]].Positon, 1.0f));
+	}
+	BVH bvh(trianglePositions);
+	const int DEPTH_TEST_STRIDE = 8;
+	bool passed = true;
+	for (int face = 0; face < 6; face++)
+	{
+		vector<float> depths;
+		vulkan->ReadDepthFace(pass.target, face, depths);
+		GLuint covered = 0;
+		float nearest = 1.0f;
+		for (unsigned int t = 0; t < depths.size(); t++)
+		{
+			if (depths[t] < 1.0f)
+				covered++;
+			nearest = glm::min(nearest, depths[t]);
+		}
+		glm::mat4 inverseFace = glm::inverse(shadowMatrices[face]);
+		GLuint sampled = 0, mismatched = 0;
+		for (int row = DEPTH_TEST_STRIDE / 2; row < (int)SHADOW_HEIGHT; row += DEPTH_TEST_STRIDE)
+			for (int column = DEPTH_TEST_STRIDE / 2; column < (int)SHADOW_WIDTH; column += DEPTH_TEST_STRIDE)
+			{
+				glm::vec4 farPoint = inverseFace * glm::vec4((column + 0.5f) / SHADOW_WIDTH * 2.0f - 1.0f, (row + 0.5f) / SHADOW_HEIGHT * 2.0f - 1.0f, 1.0f, 1.0f);
+				glm::vec3 dir = glm::normalize(glm::vec3(farPoint) / farPoint.w - lightPos);
+				GLfloat distance = depths[row * SHADOW_WIDTH + column] * far;
+				// free just short of the stored depth and blocked just past it
+				if (bvh.Occluded(lightPos, dir, distance * 0.99f) || !bvh.Occluded(lightPos, dir, distance * 1.01f))
+					mismatched++;
+				sampled++;
+			}
+		cout << "face " << face << ": " << faceDraws[face].size() << " draws, " << covered * 100.0f / depths.size() << "% covered, nearest caster at " << nearest * far
+			<< ", " << mismatched << " of " << sampled << " sampled texels off the ray cast" << endl;
+		// silhouette texels may round either way
+		if (covered != depths.size() || mismatched * 100 > sampled)
+			passed = false;
+	}
+	delete vulkan;
+	cout << (passed ? "vulkan depth test passed" : "ERROR::VULKAN::DEPTH_TEST_FAILED") << endl;
+	return passed ? 0 : -1;
+}